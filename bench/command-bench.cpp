@@ -0,0 +1,175 @@
+#include "catch2/catch.hpp"
+
+#include "shapes.hpp"
+
+#include "block.hpp"
+#include "command.hpp"
+#include "commands.hpp"
+
+using bench::doubleBlock;
+using bench::SIZES;
+
+namespace {
+
+const gs2::Value::IntType BIG{"1267650600228229401496703205376"};
+
+// A block which does nothing, for the commands which run blocks
+gs2::Block nopBlock() {
+    return gs2::Block{};
+}
+
+} // anonymous namespace
+
+TEST_CASE("Benchmark commands without arguments", "[bench][commands]") {
+    bench::command("ascii-digits", gs2::asciiDigits, [] { return gs2::List{}; });
+    bench::command("counter", gs2::counter, [] { return gs2::List{}; });
+    bench::command("empty-block", gs2::emptyBlock, [] { return gs2::List{}; });
+    bench::command("empty-list", gs2::emptyList, [] { return gs2::List{}; });
+    bench::command("lowercase-alphabet", gs2::lowercaseAlphabet, [] { return gs2::List{}; });
+    bench::command("new-line", gs2::newLine, [] { return gs2::List{}; });
+    bench::command("printable-ascii", gs2::printableAscii, [] { return gs2::List{}; });
+    bench::command("space", gs2::space, [] { return gs2::List{}; });
+    bench::command("uppercase-alphabet", gs2::uppercaseAlphabet, [] { return gs2::List{}; });
+}
+
+TEST_CASE("Benchmark stack commands", "[bench][commands]") {
+    for (auto size: SIZES) {
+        auto list = bench::nested(size);
+
+        bench::command(bench::name("dup nested", size), gs2::dup, [&] { return bench::stack(list); });
+        bench::command(bench::name("dup2 nested", size), gs2::dup2, [&] { return bench::stack(list, list); });
+    }
+
+    // Popping takes the same time however long the list is
+    for (size_t size: {16, 1024}) {
+        auto list = bench::nested(size);
+
+        bench::command(bench::name("pop nested", size), gs2::pop, [&] { return bench::stack(list); });
+        bench::command(bench::name("pop2 nested", size), gs2::pop2, [&] { return bench::stack(list, list); });
+    }
+}
+
+TEST_CASE("Benchmark arithmetic commands", "[bench][commands]") {
+    bench::command("add small ints", gs2::catenate, [] { return bench::stack(1234, 5678); });
+    bench::command("add bigints", gs2::catenate, [] { return bench::stack(BIG, BIG); });
+    bench::command("multiply small ints", gs2::fold, [] { return bench::stack(1234, 5678); });
+    bench::command("multiply bigints", gs2::fold, [] { return bench::stack(BIG, BIG); });
+    bench::command("mod small ints", gs2::mod, [] { return bench::stack(123456, 789); });
+    bench::command("mod bigints", gs2::mod, [] { return bench::stack(BIG * BIG, BIG + 12345); });
+    bench::command("abs small int", gs2::abs, [] { return bench::stack(-1234); });
+    bench::command("abs bigint", gs2::abs, [] { return bench::stack(BIG * -1); });
+    bench::command("negate small int", gs2::negate, [] { return bench::stack(1234); });
+    bench::command("negate bigint", gs2::negate, [] { return bench::stack(BIG); });
+    bench::command("bnot small int", gs2::head, [] { return bench::stack(1234); });
+    bench::command("bnot bigint", gs2::head, [] { return bench::stack(BIG); });
+    bench::command("not small int", gs2::tail, [] { return bench::stack(1234); });
+    bench::command("double small int", gs2::lines, [] { return bench::stack(1234); });
+    bench::command("double bigint", gs2::lines, [] { return bench::stack(BIG); });
+    bench::command("half small int", gs2::unlines, [] { return bench::stack(1234); });
+    bench::command("half bigint", gs2::unlines, [] { return bench::stack(BIG); });
+    bench::command("even small int", gs2::sum, [] { return bench::stack(1234); });
+    bench::command("odd bigint", gs2::product, [] { return bench::stack(BIG); });
+    bench::command("digits small int", gs2::last, [] { return bench::stack(123456789); });
+    bench::command("digits bigint", gs2::last, [] { return bench::stack(BIG); });
+}
+
+TEST_CASE("Benchmark list commands", "[bench][commands]") {
+    for (auto size: SIZES) {
+        auto bytes = bench::bytes(size);
+        auto nested = bench::nested(size);
+        auto smallInts = bench::smallInts(size);
+        auto bigInts = bench::bigInts(size);
+
+        bench::command(bench::name("catenate bytes", size), gs2::catenate, [&] { return bench::stack(bytes, bytes); });
+        bench::command(bench::name("catenate nested", size), gs2::catenate, [&] { return bench::stack(nested, nested); });
+        bench::command(bench::name("append to nested", size), gs2::catenate, [&] { return bench::stack(nested, 42); });
+        bench::command(bench::name("prepend to nested", size), gs2::catenate, [&] { return bench::stack(42, nested); });
+
+        bench::command(bench::name("reverse bytes", size), gs2::negate, [&] { return bench::stack(bytes); });
+        bench::command(bench::name("reverse nested", size), gs2::negate, [&] { return bench::stack(nested); });
+
+        bench::command(bench::name("range", size), gs2::range, [&] { return bench::stack(static_cast<int64_t>(size)); });
+        bench::command(bench::name("range1", size), gs2::range1, [&] { return bench::stack(static_cast<int64_t>(size)); });
+
+        bench::command(bench::name("step nested", size), gs2::mod, [&] { return bench::stack(nested, 3); });
+        bench::command(bench::name("join nested", size), gs2::fold, [&] {
+            return bench::stack(nested, gs2::makeList(", "));
+        });
+        bench::command(bench::name("repeat bytes", size), gs2::fold, [&] {
+            return bench::stack(bench::bytes(16), static_cast<int64_t>(size));
+        });
+
+        bench::command(bench::name("sum small ints", size), gs2::sum, [&] { return bench::stack(smallInts); });
+        bench::command(bench::name("sum bigints", size), gs2::sum, [&] { return bench::stack(bigInts); });
+        bench::command(bench::name("sum range", size), gs2::sum, [&] {
+            return bench::stack(gs2::List{gs2::List::Range{1, 1, size}});
+        });
+    }
+
+    // Taking one element off either end takes the same time however long
+    // the list is, apart from copying lists which are shared, which init,
+    // last and tail do since the stacks are copies of one list
+    for (size_t size: {16, 1024}) {
+        auto bytes = bench::bytes(size);
+        auto nested = bench::nested(size);
+
+        bench::command(bench::name("init bytes", size), gs2::abs, [&] { return bench::stack(bytes); });
+        bench::command(bench::name("head nested", size), gs2::head, [&] { return bench::stack(nested); });
+        bench::command(bench::name("last nested", size), gs2::last, [&] { return bench::stack(nested); });
+        bench::command(bench::name("tail bytes", size), gs2::tail, [&] { return bench::stack(bytes); });
+        bench::command(bench::name("length nested", size), gs2::range, [&] { return bench::stack(nested); });
+    }
+
+    // Products grow with the length of the list, so they're kept shorter
+    for (size_t size: {16, 1024}) {
+        auto smallInts = bench::smallInts(size);
+        auto bigInts = bench::bigInts(size);
+
+        bench::command(bench::name("product small ints", size), gs2::product, [&] { return bench::stack(smallInts); });
+        bench::command(bench::name("product bigints", size), gs2::product, [&] { return bench::stack(bigInts); });
+        bench::command(bench::name("product range", size), gs2::product, [&] {
+            return bench::stack(gs2::List{gs2::List::Range{1, 1, size}});
+        });
+    }
+}
+
+TEST_CASE("Benchmark string commands", "[bench][commands]") {
+    bench::command("show small int", gs2::show, [] { return bench::stack(1234); });
+    bench::command("show bigint", gs2::show, [] { return bench::stack(BIG); });
+    bench::command("show-line small int", gs2::showLine, [] { return bench::stack(1234); });
+    bench::command("show-space bigint", gs2::showSpace, [] { return bench::stack(BIG); });
+
+    for (auto size: SIZES) {
+        auto bytes = bench::bytes(size);
+        auto nested = bench::nested(size);
+        auto smallInts = bench::smallInts(size);
+        auto space = gs2::makeList(" ");
+
+        bench::command(bench::name("show nested", size), gs2::show, [&] { return bench::stack(nested); });
+        bench::command(bench::name("show-lines nested", size), gs2::showLines, [&] { return bench::stack(nested); });
+        bench::command(bench::name("show-words nested", size), gs2::showWords, [&] { return bench::stack(nested); });
+        bench::command(bench::name("unlines nested", size), gs2::unlines, [&] { return bench::stack(nested); });
+        bench::command(bench::name("unlines small ints", size), gs2::unlines, [&] { return bench::stack(smallInts); });
+
+        bench::command(bench::name("lines bytes", size), gs2::lines, [&] { return bench::stack(bytes); });
+        bench::command(bench::name("clean-split bytes", size), gs2::mod, [&] { return bench::stack(bytes, space); });
+        bench::command(bench::name("read-num bytes", size), gs2::readNum, [&] { return bench::stack(bytes); });
+        bench::command(bench::name("read-nums bytes", size), gs2::readNums, [&] { return bench::stack(bytes); });
+    }
+}
+
+TEST_CASE("Benchmark block commands", "[bench][commands]") {
+    bench::command("evaluate", gs2::negate, [] { return bench::stack(1234, doubleBlock()); });
+
+    for (auto size: SIZES) {
+        auto smallInts = bench::smallInts(size);
+        auto nested = bench::nested(size);
+
+        bench::command(bench::name("times", size), gs2::fold, [&] {
+            return bench::stack(nopBlock(), static_cast<int64_t>(size));
+        });
+        bench::command(bench::name("map small ints", size), gs2::mod, [&] { return bench::stack(smallInts, doubleBlock()); });
+        bench::command(bench::name("map nested", size), gs2::mod, [&] { return bench::stack(nested, doubleBlock()); });
+        bench::command(bench::name("fold small ints", size), gs2::fold, [&] { return bench::stack(smallInts, doubleBlock()); });
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// A program in bench/corpus, how to make input of about the given size for
+// it, and the fastest its running time may grow with the size of its input,
+// as an exponent
+struct CorpusProgram {
+    std::string name;
+    std::function<std::string(size_t)> makeInput;
+    double maxExponent;
+};
+
+// Makes a deterministic sequence of numbers, so that runs can be compared
+class Numbers {
+    private:
+        uint64_t _state = 0x2545f4914f6cdd1d;
+
+    public:
+        uint64_t next(uint64_t limit) {
+            _state = _state * 6364136223846793005 + 1442695040888963407;
+            return (_state >> 33) % limit;
+        }
+};
+
+// Lines of between 1 and 16 numbers, some of them negative
+inline std::string numberLines(size_t size) {
+    Numbers numbers;
+    std::string input;
+
+    while (input.size() < size) {
+        auto count = numbers.next(16) + 1;
+        for (uint64_t i = 0; i < count; i++) {
+            if (i > 0) {
+                input += ' ';
+            }
+            if (numbers.next(4) == 0) {
+                input += '-';
+            }
+            input += std::to_string(numbers.next(100000));
+        }
+        input += '\n';
+    }
+
+    return input;
+}
+
+// Lines of words of lowercase letters
+inline std::string textLines(size_t size) {
+    Numbers numbers;
+    std::string input;
+
+    while (input.size() < size) {
+        auto count = numbers.next(12) + 1;
+        for (uint64_t i = 0; i < count; i++) {
+            if (i > 0) {
+                input += ' ';
+            }
+            auto length = numbers.next(8) + 1;
+            for (uint64_t j = 0; j < length; j++) {
+                input += static_cast<char>('a' + numbers.next(26));
+            }
+        }
+        input += '\n';
+    }
+
+    return input;
+}
+
+// Just a count, scaled down from the size since these programs do a lot of
+// work for each number
+inline std::function<std::string(size_t)> count(size_t divisor) {
+    return [divisor] (size_t size) {
+        return std::to_string(std::max<size_t>(size / divisor, 1)) + '\n';
+    };
+}
+
+// The factorial multiplies bigints which grow with the count, so it's
+// allowed to be quadratic
+inline const std::vector<CorpusProgram> CORPUS = {
+    {"line-sums", numberLines, 1.5},
+    {"line-reverse", textLines, 1.5},
+    {"sum-of-squares", count(16), 1.5},
+    {"factorial-fold", count(256), 2.3},
+    {"word-count", textLines, 1.5},
+    {"join-lines", textLines, 1.5},
+    {"nested-maps", numberLines, 1.5},
+};
+
+} // namespace bench
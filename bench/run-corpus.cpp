@@ -0,0 +1,189 @@
+// Runs the gs2 interpreter over each program in the benchmark corpus, with
+// generated input, and prints the wall time, peak memory use and number of
+// instructions retired for each one as CSV.
+
+#include "corpus.hpp"
+
+#include <CLI/CLI.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+
+namespace {
+
+struct Result {
+    double seconds;
+    long maxRssKb;
+    std::optional<uint64_t> instructions;
+    bool failed;
+};
+
+// Counts the instructions a process retires in user space, starting from
+// when it calls exec
+int openInstructionCounter(pid_t pid) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0));
+}
+
+std::optional<Result> run(const std::string &gs2, const std::string &program,
+                          const std::string &inputPath, const std::string &errorPath)
+{
+    // The child waits for the counter to be set up before running gs2
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return std::nullopt;
+    }
+
+    auto pid = fork();
+
+    if (pid < 0) {
+        return std::nullopt;
+    }
+    else if (pid == 0) {
+        close(ready[1]);
+        char c;
+        if (read(ready[0], &c, 1) != 1) {
+            _exit(127);
+        }
+
+        auto input = open(inputPath.c_str(), O_RDONLY);
+        auto output = open("/dev/null", O_WRONLY);
+        auto error = open(errorPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (input < 0 || output < 0 || error < 0) {
+            _exit(127);
+        }
+        dup2(input, STDIN_FILENO);
+        dup2(output, STDOUT_FILENO);
+        dup2(error, STDERR_FILENO);
+
+        execl(gs2.c_str(), gs2.c_str(), program.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+
+    close(ready[0]);
+    auto counter = openInstructionCounter(pid);
+    auto start = std::chrono::steady_clock::now();
+    if (write(ready[1], "x", 1) != 1) {
+        kill(pid, SIGKILL);
+    }
+    close(ready[1]);
+
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.maxRssKb = usage.ru_maxrss;
+
+    uint64_t instructions;
+    if (counter >= 0 && read(counter, &instructions, sizeof(instructions)) == sizeof(instructions)) {
+        result.instructions = instructions;
+    }
+    if (counter >= 0) {
+        close(counter);
+    }
+
+    // gs2 prints the program instead of failing, but errors go to stderr
+    std::ifstream errors{errorPath};
+    result.failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+                    errors.peek() != std::ifstream::traits_type::eof();
+    return result;
+}
+
+std::string makeTempPath(const std::string &tag) {
+    std::string path = "/tmp/gs2-bench-" + tag + "-XXXXXX";
+    auto fd = mkstemp(path.data());
+    if (fd >= 0) {
+        close(fd);
+    }
+    return path;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    std::string gs2;
+    std::string corpus;
+    std::string filter;
+    size_t size = 1 << 20;
+    int repeat = 3;
+
+    CLI::App app{"Runs the gs2 interpreter over the benchmark corpus."};
+    app.add_option("--gs2", gs2, "The gs2 interpreter to run.")->required();
+    app.add_option("--corpus", corpus, "The directory holding the corpus programs.")->required();
+    app.add_option("--size", size, "About how many bytes of input to give each program.");
+    app.add_option("--repeat", repeat, "How many times to run each program, keeping the fastest run.")
+       ->check(CLI::Range(1, 1000));
+    app.add_option("--filter", filter, "Only run programs whose names contain this.");
+    CLI11_PARSE(app, argc, argv);
+
+    auto inputPath = makeTempPath("input");
+    auto errorPath = makeTempPath("errors");
+    bool anyFailed = false;
+
+    std::cout << "program,input_bytes,wall_seconds,max_rss_kb,instructions\n";
+
+    for (const auto &program: bench::CORPUS) {
+        if (program.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        auto input = program.makeInput(size);
+        std::ofstream{inputPath, std::ios_base::binary} << input;
+
+        std::optional<Result> best;
+        for (int i = 0; i < repeat; i++) {
+            auto result = run(gs2, corpus + "/" + program.name + ".gs2", inputPath, errorPath);
+            if (!result || result->failed) {
+                std::cerr << program.name << " failed\n";
+                anyFailed = true;
+                best.reset();
+                break;
+            }
+            if (!best || result->seconds < best->seconds) {
+                best = result;
+            }
+        }
+
+        if (!best) {
+            continue;
+        }
+
+        std::cout << program.name << ',' << input.size() << ',' << best->seconds << ','
+                  << best->maxRssKb << ',';
+        if (best->instructions) {
+            std::cout << *best->instructions;
+        }
+        std::cout << '\n';
+    }
+
+    std::remove(inputPath.c_str());
+    std::remove(errorPath.c_str());
+    return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+// Runs commands and corpus programs over inputs of geometrically increasing
+// size, fits how fast their running time grows, and fails if it grows faster
+// than each one is allowed to. This catches code which is accidentally
+// quadratic, which only shows up once the input is big.
+
+#include "corpus.hpp"
+#include "shapes.hpp"
+
+#include "block.hpp"
+#include "command.hpp"
+#include "commands.hpp"
+#include "gs2context.hpp"
+#include "program.hpp"
+
+#include <CLI/CLI.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Most of the commands are linear, but the biggest inputs don't fit in the
+// cache, so there's some room above 1 while still catching anything quadratic
+constexpr double LINEAR = 1.5;
+
+// Something which is timed at each size. prepare builds the input for a
+// size, outside of the timing, and returns what should be timed.
+struct ScalingCase {
+    std::string name;
+    double maxExponent;
+    std::function<std::function<void()>(size_t)> prepare;
+};
+
+// Times a command run on a stack made by makeStack
+template <typename MakeStack>
+ScalingCase command(const std::string &name, gs2::CommandFn fn, MakeStack makeStack,
+                    double maxExponent = LINEAR)
+{
+    return {name, maxExponent, [fn, makeStack] (size_t size) {
+        auto stack = makeStack(size);
+        return std::function<void()>{[fn, stack] {
+            auto copy = stack;
+            gs2::GS2Context gs2{copy};
+            fn(gs2);
+        }};
+    }};
+}
+
+std::vector<ScalingCase> commandCases() {
+    using bench::stack;
+
+    return {
+        command("catenate nested", gs2::catenate, [] (size_t size) {
+            return stack(bench::nested(size), bench::nested(size));
+        }),
+        command("reverse nested", gs2::negate, [] (size_t size) { return stack(bench::nested(size)); }),
+        command("range", gs2::range, [] (size_t size) { return stack(static_cast<int64_t>(size)); }),
+        command("join nested", gs2::fold, [] (size_t size) {
+            return stack(bench::nested(size), gs2::makeList(", "));
+        }),
+        command("sum small ints", gs2::sum, [] (size_t size) { return stack(bench::smallInts(size)); }),
+        command("sum bigints", gs2::sum, [] (size_t size) { return stack(bench::bigInts(size)); }),
+        command("show nested", gs2::show, [] (size_t size) { return stack(bench::nested(size)); }),
+        command("show-lines nested", gs2::showLines, [] (size_t size) { return stack(bench::nested(size)); }),
+        command("show-words nested", gs2::showWords, [] (size_t size) { return stack(bench::nested(size)); }),
+        command("unlines nested", gs2::unlines, [] (size_t size) { return stack(bench::nested(size)); }),
+        command("lines bytes", gs2::lines, [] (size_t size) { return stack(bench::bytes(size)); }),
+        command("clean-split bytes", gs2::mod, [] (size_t size) {
+            return stack(bench::bytes(size), gs2::makeList(" "));
+        }),
+        command("read-nums bytes", gs2::readNums, [] (size_t size) { return stack(bench::bytes(size)); }),
+        command("map small ints", gs2::mod, [] (size_t size) {
+            return stack(bench::smallInts(size), bench::doubleBlock());
+        }),
+        command("fold small ints", gs2::fold, [] (size_t size) {
+            return stack(bench::smallInts(size), bench::doubleBlock());
+        }),
+
+        // Building up a list or a block one piece at a time, which is
+        // quadratic if each step copies everything before it
+        {"prepend to nested repeatedly", LINEAR, [] (size_t size) {
+            return std::function<void()>{[size] {
+                auto values = stack(gs2::List{});
+                gs2::GS2Context gs2{values};
+                for (size_t i = 0; i < size; i++) {
+                    auto list = gs2.pop();
+                    gs2.push(static_cast<int64_t>(i));
+                    gs2.push(std::move(list));
+                    gs2::catenate(gs2);
+                }
+            }};
+        }},
+        {"append to nested repeatedly", LINEAR, [] (size_t size) {
+            return std::function<void()>{[size] {
+                auto values = stack(gs2::List{});
+                gs2::GS2Context gs2{values};
+                for (size_t i = 0; i < size; i++) {
+                    gs2.push(static_cast<int64_t>(i));
+                    gs2::catenate(gs2);
+                }
+            }};
+        }},
+        {"concatenate blocks repeatedly", LINEAR, [] (size_t size) {
+            return std::function<void()>{[size] {
+                gs2::Block block;
+                for (size_t i = 0; i < size; i++) {
+                    block.concat(bench::doubleBlock());
+                }
+                block.getCommands();
+            }};
+        }},
+    };
+}
+
+std::vector<ScalingCase> corpusCases(const std::string &corpus) {
+    std::vector<ScalingCase> cases;
+
+    for (const auto &program: bench::CORPUS) {
+        std::ifstream file{corpus + "/" + program.name + ".gs2", std::ios_base::binary};
+        if (!file.is_open()) {
+            std::cerr << "Unable to open the corpus program " << program.name << '\n';
+            continue;
+        }
+        std::vector<uint8_t> code{std::istreambuf_iterator<char>{file}, {}};
+        auto compiled = gs2::Program::compile(gs2::Block::parseBytes(code), 1);
+
+        cases.push_back({"corpus " + program.name, program.maxExponent, [program, compiled] (size_t size) {
+            auto input = gs2::makeList(program.makeInput(size));
+            return std::function<void()>{[compiled, input] {
+                auto stack = bench::stack(input);
+                gs2::GS2Context gs2{stack};
+                gs2::Block{compiled, 0}.execute(gs2);
+            }};
+        }});
+    }
+
+    return cases;
+}
+
+// The fastest of a few runs, to keep noise out of the fit
+double timeRun(const std::function<void()> &run) {
+    using Clock = std::chrono::steady_clock;
+
+    double best = 0;
+    auto started = Clock::now();
+
+    for (int i = 0; i < 3 || Clock::now() - started < std::chrono::milliseconds{100}; i++) {
+        auto start = Clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (i == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+
+    return best;
+}
+
+// The slope of the least squares line through log(time) against log(size)
+double fitExponent(const std::vector<size_t> &sizes, const std::vector<double> &times) {
+    double n = static_cast<double>(times.size());
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+
+    for (size_t i = 0; i < times.size(); i++) {
+        double x = std::log(static_cast<double>(sizes[i]));
+        double y = std::log(times[i]);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+
+    return (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    std::string corpus;
+    std::string filter;
+    size_t minSize = 4096;
+    int steps = 5;
+    double maxSeconds = 2;
+
+    CLI::App app{"Checks how the running time of gs2 commands and programs grows with their input."};
+    app.add_option("--corpus", corpus, "The directory holding the corpus programs, which are skipped if not given.");
+    app.add_option("--filter", filter, "Only run cases whose names contain this.");
+    app.add_option("--min-size", minSize, "The smallest size each case is run at.");
+    app.add_option("--steps", steps, "How many sizes to run each case at, each four times the last.")
+       ->check(CLI::Range(3, 10));
+    app.add_option("--max-seconds", maxSeconds, "Stop growing a case once a run takes longer than this.");
+    CLI11_PARSE(app, argc, argv);
+
+    auto cases = commandCases();
+    if (!corpus.empty()) {
+        auto programs = corpusCases(corpus);
+        cases.insert(cases.end(), programs.begin(), programs.end());
+    }
+
+    bool anyFailed = false;
+
+    for (const auto &scalingCase: cases) {
+        if (scalingCase.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        std::vector<size_t> sizes;
+        std::vector<double> times;
+
+        for (size_t size = minSize; sizes.size() < static_cast<size_t>(steps); size *= 4) {
+            auto seconds = timeRun(scalingCase.prepare(size));
+            sizes.push_back(size);
+            times.push_back(seconds);
+            if (seconds > maxSeconds) {
+                break;
+            }
+        }
+
+        // Two sizes are too few to tell a curve from noise, so a case which
+        // gets too slow to run a third time has failed anyway
+        bool failed = sizes.size() < 3;
+        double exponent = failed ? 0 : fitExponent(sizes, times);
+        failed = failed || exponent > scalingCase.maxExponent;
+        anyFailed = anyFailed || failed;
+
+        std::printf("%-5s %-40s exponent %.2f (at most %.2f), %zu to %zu took %.3gs to %.3gs\n",
+                    failed ? "FAIL" : "ok", scalingCase.name.c_str(), exponent,
+                    scalingCase.maxExponent, sizes.front(), sizes.back(), times.front(), times.back());
+    }
+
+    return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "command.hpp"
+#include "commands.hpp"
+#include "gs2context.hpp"
+#include "utils.hpp"
+#include "value.hpp"
+
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// The list sizes most benchmarks are run over
+inline const std::vector<size_t> SIZES = {16, 1024, 65536};
+
+// Numbers which are too big for a byte string, but fit in 64 bits
+inline gs2::List smallInts(size_t count) {
+    gs2::List list;
+    for (size_t i = 0; i < count; i++) {
+        list.add(static_cast<int64_t>(i % 1000 + 256));
+    }
+    return list;
+}
+
+// Numbers which need a bigint, all around 2^100
+inline gs2::List bigInts(size_t count) {
+    gs2::List list;
+    gs2::Value::IntType big{"1267650600228229401496703205376"};
+    for (size_t i = 0; i < count; i++) {
+        list.add(big + static_cast<int64_t>(i));
+    }
+    return list;
+}
+
+// Text made up of numbers and words, with spaces between them and a newline
+// every few words
+inline std::string text(size_t size) {
+    std::string str;
+    for (size_t i = 0; str.size() < size; i++) {
+        str += (i % 3 == 0 ? "w" + std::to_string(i) : std::to_string(i * 37));
+        str += (i % 8 == 7 ? '\n' : ' ');
+    }
+    str.resize(size);
+    return str;
+}
+
+inline gs2::List bytes(size_t size) {
+    return gs2::makeList(text(size));
+}
+
+// A list of short byte strings
+inline gs2::List nested(size_t count) {
+    gs2::List list;
+    for (size_t i = 0; i < count; i++) {
+        list.add(gs2::makeList("item" + std::to_string(i)));
+    }
+    return list;
+}
+
+// A block which duplicates whatever it's given, then adds the copies
+inline gs2::Block doubleBlock() {
+    gs2::Block block;
+    block.add(gs2::Command{std::vector<uint8_t>{0x40}});
+    block.add(gs2::Command{std::vector<uint8_t>{0x30}});
+    return block;
+}
+
+inline std::string name(const std::string &base, size_t size) {
+    return base + " (" + std::to_string(size) + ")";
+}
+
+// Benchmarks running a command on the stack made by makeStack. The stacks
+// are all built before timing starts, since commands consume their
+// arguments. Catch asks for millions of them for the fastest commands, so
+// makeStack should copy inputs built once per size, which share their
+// elements, rather than building new ones.
+template <typename MakeStack>
+void command(const std::string &name, gs2::CommandFn fn, MakeStack makeStack) {
+    BENCHMARK_ADVANCED(std::string{name})(Catch::Benchmark::Chronometer meter) {
+        std::vector<gs2::List> stacks;
+        stacks.reserve(meter.runs());
+        for (int i = 0; i < meter.runs(); i++) {
+            stacks.push_back(makeStack());
+        }
+
+        meter.measure([&] (int i) {
+            gs2::GS2Context gs2{stacks[i]};
+            fn(gs2);
+        });
+    };
+}
+
+// Makes a stack from the given values
+template <typename... Values>
+gs2::List stack(Values... values) {
+    gs2::List list;
+    (list.add(gs2::Value{std::move(values)}), ...);
+    return list;
+}
+
+} // namespace bench
@@ -0,0 +1,68 @@
+#include "catch2/catch.hpp"
+
+#include "shapes.hpp"
+
+#include "utils.hpp"
+#include "value.hpp"
+
+using bench::SIZES;
+
+TEST_CASE("Benchmark utilities", "[bench][utils]") {
+    for (auto size: SIZES) {
+        auto str = bench::text(size);
+        auto bytes = bench::bytes(size);
+        auto nested = bench::nested(size);
+        auto smallInts = bench::smallInts(size);
+        auto bigInts = bench::bigInts(size);
+        auto space = gs2::makeList(" ");
+        auto separator = gs2::makeList("7 ");
+        gs2::List numberSeparator;
+        numberSeparator.add(300);
+
+        BENCHMARK(bench::name("makeList", size)) {
+            return gs2::makeList(str);
+        };
+        BENCHMARK(bench::name("makeString bytes", size)) {
+            return gs2::makeString(bytes);
+        };
+        BENCHMARK(bench::name("makeString small ints", size)) {
+            return gs2::makeString(smallInts);
+        };
+        BENCHMARK(bench::name("join nested", size)) {
+            return gs2::join(nested, space);
+        };
+        BENCHMARK(bench::name("split bytes on a byte", size)) {
+            return gs2::split(bytes, space);
+        };
+        BENCHMARK(bench::name("split bytes on bytes", size)) {
+            return gs2::split(bytes, separator);
+        };
+        BENCHMARK(bench::name("split small ints", size)) {
+            return gs2::split(smallInts, numberSeparator);
+        };
+        BENCHMARK(bench::name("stepOver nested", size)) {
+            return gs2::stepOver(nested, 2);
+        };
+        BENCHMARK(bench::name("containsBlock nested", size)) {
+            return gs2::containsBlock(nested);
+        };
+        BENCHMARK(bench::name("sumList small ints", size)) {
+            return gs2::sumList(smallInts);
+        };
+        BENCHMARK(bench::name("sumList bigints", size)) {
+            return gs2::sumList(bigInts);
+        };
+    }
+
+    for (size_t size: {16, 1024}) {
+        auto smallInts = bench::smallInts(size);
+        auto bigInts = bench::bigInts(size);
+
+        BENCHMARK(bench::name("productList small ints", size)) {
+            return gs2::productList(smallInts);
+        };
+        BENCHMARK(bench::name("productList bigints", size)) {
+            return gs2::productList(bigInts);
+        };
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory_resource>
+
+namespace gs2 {
+
+// While an arena exists, lists and blocks get their memory from a pool
+// instead of going to the global heap for every allocation. Memory freed
+// back to the pool is reused by later allocations of the same size, which
+// is most of them when the same program runs over and over.
+//
+// The arena is installed as the default memory resource, so it has to
+// outlive every list and block created while it was in use.
+class Arena {
+    private:
+        std::pmr::synchronized_pool_resource _pool;
+        std::pmr::memory_resource *_previous;
+
+    public:
+        Arena();
+        ~Arena();
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+};
+
+} // namespace gs2
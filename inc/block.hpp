@@ -1,35 +1,65 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace gs2 {
 
 class Command;
 class GS2Context;
+class Program;
 
+// Blocks are immutable once they've been copied, so copies share their
+// commands, and concatenating two blocks just links them together.
 class Block {
     private:
-        std::vector<Command> _commands;
+        struct Node;
+
+        // Either a list of parsed commands, or the concatenation of two blocks
+        std::shared_ptr<Node> _node;
+
+        // Set instead of _node for blocks which were pushed by a running
+        // program, and refer to their code inside of that program
+        std::shared_ptr<const Program> _program;
+        size_t _index;
+
+        template <typename Fn>
+        void forEachPiece(Fn fn) const;
 
     public:
         Block();
+        Block(std::shared_ptr<const Program> program, size_t index);
         Block(const Block &);
-        Block(Block &&);
+        Block(Block &&) noexcept;
         Block& operator=(const Block &);
-        Block& operator=(Block &&);
+        Block& operator=(Block &&) noexcept;
         ~Block();
 
         bool operator!=(const Block &rhs) const;
 
         static Block parseBytes(const std::vector<uint8_t> &code);
 
+        // Whether the code is a line mode program, whose block gets mapped
+        // over each line of the input, and the block without the commands
+        // which split up the input and join the results
+        static bool isLineMode(const std::vector<uint8_t> &code);
+        static Block parseBody(const std::vector<uint8_t> &code);
+
         void add(Command command);
         void concat(const Block &block);
 
         void execute(GS2Context &gs2) const;
 
         const std::vector<Command> &getCommands() const;
+
+        // For a concatenation of two blocks, the blocks which were joined
+        bool isConcatenation() const;
+        const Block &getFirst() const;
+        const Block &getSecond() const;
+
+        const Program &getProgram() const;
+        size_t getProgramIndex() const;
 };
 
 } // namespace gs2
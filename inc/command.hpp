@@ -2,6 +2,7 @@
 
 #include "block.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <variant>
@@ -17,12 +18,16 @@ class Command {
             Block
         > _command;
 
+        // Where the command starts in the source file
+        size_t _offset;
+
         static void executeBytes(const std::vector<uint8_t> &bytes, GS2Context &gs2);
 
     public:
-        Command(std::vector<uint8_t> bytes);
-        Command(Block block);
+        Command(std::vector<uint8_t> bytes, size_t offset = 0);
+        Command(Block block, size_t offset = 0);
 
+        // Commands at different offsets are still the same command
         bool operator!=(const Command &rhs) const;
 
         void execute(GS2Context &gs2) const;
@@ -32,6 +37,8 @@ class Command {
 
         bool isBlock() const;
         const Block &getBlock() const;
+
+        size_t getOffset() const;
 };
 
 constexpr uint8_t STRING_START_CMD = 0x04;
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <cstdint>
+
 namespace gs2 {
 
 class GS2Context;
 
+using CommandFn = void (*)(GS2Context &);
+
+// Returns the function implementing a single-byte command, or nullptr if the
+// byte isn't a command which can be executed on its own
+CommandFn findCommand(uint8_t byte);
+
+// Returns the names of a single-byte command, like "mod / step / clean-split
+// / map", or nullptr for the same bytes findCommand has no function for
+const char *findCommandName(uint8_t byte);
+
 void abs(GS2Context &);
 
 void asciiDigits(GS2Context &);
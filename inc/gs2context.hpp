@@ -1,17 +1,46 @@
 #pragma once
 
+#include "interpreter.hpp"
 #include "value.hpp"
 
 #include <iosfwd>
+#include <memory>
 
 namespace gs2 {
 
+// How blocks get executed. The tree walker runs the parsed commands directly,
+// while the other two run the compiled program with different dispatch loops.
+enum class Engine {
+    TreeWalker,
+    Switch,
+    Threaded,
+};
+
+class Profiler;
+class Sampler;
+
 class GS2Context {
     private:
         List &_stack;
 
         int _counter;
 
+        Engine _engine;
+
+        size_t _threads;
+
+        Profiler *_profiler;
+
+        Sampler *_sampler;
+
+        Interpreter _interpreter;
+
+        void runLoop(std::unique_ptr<Loop> loop);
+
+        // Maps a pure block over a list without any blocks in it, with
+        // several threads
+        void parallelMap(const Block &block, List list);
+
     public:
         GS2Context(List &stack);
 
@@ -23,6 +52,41 @@ class GS2Context {
 
         int getAndIncCounter();
 
+        size_t getStackSize() const;
+
+        // Removes everything above the first stackSize values, and gives it
+        // back as a list
+        List popAbove(size_t stackSize);
+
+        Engine getEngine() const;
+        void setEngine(Engine engine);
+
+        // How many threads map can use for blocks which are pure. Defaults
+        // to 1, which runs everything on the calling thread.
+        size_t getThreads() const;
+        void setThreads(size_t threads);
+
+        // When there's a profiler, blocks are always run by the interpreter,
+        // whatever the engine, and every instruction is timed. Maps stay on
+        // this thread while profiling, so their commands are counted. Null
+        // by default.
+        Profiler *getProfiler() const;
+        void setProfiler(Profiler *profiler);
+
+        // When there's a sampler, blocks are always run by the interpreter
+        // too, and it takes a sample between instructions whenever one is
+        // due. Null by default.
+        Sampler *getSampler() const;
+        void setSampler(Sampler *sampler);
+
+        Interpreter &getInterpreter();
+
+        // These run blocks for commands. While the interpreter is running,
+        // the blocks only start once the command returns, so they should be
+        // the last thing a command does.
+        void evaluate(const Block &block);
+        void times(const Block &block, Value::IntType count);
+        void fold(const Block &block, List list);
         void do_map(const Block &block, List val);
 };
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "list.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gs2 {
+
+// Reads everything left in a file descriptor. What's left of a regular file
+// is mapped into memory, and the list reads it from there without copying it
+// until the list is modified. Anything else, like a pipe, is read in large
+// chunks straight into a byte string.
+List readInput(int fd);
+
+// Reads a file descriptor one line at a time, splitting it up the same way
+// as the lines command, so that there's always at least one line. Only as
+// much of the input as the longest line is kept in memory.
+class LineReader {
+    private:
+        int _fd;
+        std::vector<uint8_t> _buffer;
+
+        // The part of the buffer which has been read but not returned yet
+        size_t _start;
+        size_t _end;
+
+        bool _finished;
+        size_t _linesRead;
+
+        // Reads more input, making room for it first, and returns how much of
+        // the unread input was moved over to make room
+        size_t fill();
+
+    public:
+        explicit LineReader(int fd);
+
+        // Reads the next line, without its newline, or returns false if
+        // there aren't any more lines
+        bool next(List::Bytes &line);
+
+        // Whether next can return without having to read more input
+        bool hasBufferedLine() const;
+};
+
+} // namespace gs2
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "block.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace gs2 {
+
+class GS2Context;
+class Program;
+struct Instruction;
+struct SampleFrame;
+
+// A command which runs a block over and over, like times, fold or map
+class Loop {
+    private:
+        Block _block;
+
+    public:
+        Loop(Block block);
+        virtual ~Loop();
+
+        const Block &getBlock() const;
+
+        // What the loop is profiled as, which is the helper that made it
+        virtual const char *getName() const = 0;
+
+        // Gets the stack ready for the next run of the block, returning true,
+        // or finishes up the loop and returns false
+        virtual bool next(GS2Context &gs2) = 0;
+};
+
+// Runs compiled blocks without recursing through C++. When a command wants
+// to run a block, the block gets a frame on the interpreter's own stack and
+// runs after the command returns.
+class Interpreter {
+    private:
+        struct Frame {
+            // The code being run, or nullptr for a loop, or for a piece of a
+            // concatenated block which hasn't been reached yet
+            const Program *program;
+            const Instruction *insn;
+
+            Block block;
+            std::unique_ptr<Loop> loop;
+        };
+
+        std::vector<Frame> _frames;
+
+        // Records where the program is to the context's sampler: the
+        // commands which called the frames below frameIndex, and then top
+        void sample(GS2Context &gs2, size_t frameIndex, const SampleFrame &top);
+
+        friend bool runSwitch(Interpreter &, GS2Context &, size_t);
+        friend bool runThreaded(Interpreter &, GS2Context &, size_t);
+        friend bool runProfiled(Interpreter &, GS2Context &, size_t);
+        friend bool runSampled(Interpreter &, GS2Context &, size_t);
+
+    public:
+        // Runs a block to completion
+        void run(GS2Context &gs2, const Block &block);
+
+        // Whether a block is being run, meaning blocks can be called instead
+        // of being run right away
+        bool isRunning() const;
+
+        // Schedules a block or a loop to run once the current command returns
+        void call(const Block &block);
+        void call(std::unique_ptr<Loop> loop);
+};
+
+// Runs the compiled block in a frame, until either it returns or one of its
+// commands calls another block. Returns true if the block returned.
+// runSwitch dispatches every instruction through a single switch, while
+// runThreaded jumps directly from the end of one instruction's handler to
+// the next.
+bool runSwitch(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex);
+bool runThreaded(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex);
+
+// Runs like runSwitch, but adds the time each instruction takes to the
+// context's profiler, which must be set
+bool runProfiled(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex);
+
+// Runs like runSwitch, but after each instruction, takes a sample if the
+// context's sampler, which must be set, has one due
+bool runSampled(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex);
+
+} // namespace gs2
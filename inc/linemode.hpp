@@ -0,0 +1,23 @@
+#pragma once
+
+#include "gs2context.hpp"
+
+namespace gs2 {
+
+class Block;
+class LineReader;
+class Output;
+class Profiler;
+class Sampler;
+
+// Runs the block of a line mode program over each line of the input as it's
+// read, writing out each line's results before going on to the next line,
+// so that output starts right away and memory use doesn't grow with the
+// size of the input. Output is flushed whenever more input has to be read.
+//
+// Each line is run on its own stack, so unlike when the lines are mapped
+// all at once, the block can't reach the results of earlier lines.
+void streamLines(const Block &block, LineReader &reader, Output &output, Engine engine,
+                 Profiler *profiler = nullptr, Sampler *sampler = nullptr);
+
+} // namespace gs2
@@ -1,19 +1,152 @@
 #pragma once
 
+#include "rope.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 
 namespace gs2 {
 
 class Value;
 
+// A list of values. Lists start out as byte strings, storing one uint8_t per
+// element, and are promoted to holding full Values the first time something
+// other than a byte is put into them. Elements can only be read in place;
+// take() moves an element out.
+//
+// Lists made by range and range1 only store where the range starts, its step
+// and its length, until something other than popping or reversing modifies
+// the list. Code which only needs the numbers, like sum, show and Output,
+// works them out from getRange(). Reading elements in place has to hand out
+// references though, so the first time one is read, every element of the
+// range is filled in and kept for as long as the range's storage is.
+//
+// Input read from a regular file starts out as Mapped bytes, which the list
+// reads straight out of the mapping. Popping and splitting only narrow which
+// part of the mapping is read, but anything else which modifies the list
+// copies the bytes into a byte string of the list's own first.
+//
+// A list which gets long enough that prepending to it, or concatenating it
+// onto another list, would mean copying lots of elements switches to being
+// stored as a Rope, so that those take O(log n) time instead. Byte strings
+// switch too, once they're much longer, and keep their elements as bytes
+// inside the rope.
+//
+// Copies of a list share their elements until one of them is modified, at
+// which point that copy gets elements of its own. Elements are allocated from
+// the default memory resource, which is a pool while an Arena is in use.
 class List {
+    public:
+        using Bytes = std::pmr::vector<uint8_t>;
+
+        // The numbers start, start + step, start + 2 * step, ... which all fit
+        // in an int64_t
+        struct Range {
+            int64_t start;
+            int64_t step;
+            size_t count;
+
+            int64_t at(size_t index) const;
+        };
+
+        // A byte string's bytes, read in place whether the list owns them or
+        // they're Mapped
+        class ByteView {
+            private:
+                const uint8_t *_data;
+                size_t _size;
+
+            public:
+                ByteView(const uint8_t *data, size_t size);
+                ByteView(const Bytes &bytes);
+
+                bool operator==(const ByteView &rhs) const;
+                bool operator!=(const ByteView &rhs) const;
+
+                const uint8_t *data() const;
+                size_t size() const;
+                bool empty() const;
+                uint8_t operator[](size_t index) const;
+
+                const uint8_t *begin() const;
+                const uint8_t *end() const;
+        };
+
+        // Bytes which the list only reads, like a file mapped into memory.
+        // Whatever owns them is kept alive for as long as any list reads them.
+        struct Mapped {
+            std::shared_ptr<const void> owner;
+            ByteView bytes;
+        };
+
+        class const_iterator {
+            private:
+                const List *_list;
+                size_t _index;
+
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = Value;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Value *;
+                using reference = const Value &;
+
+                const_iterator(const List *list, size_t index);
+
+                reference operator*() const;
+                pointer operator->() const;
+                reference operator[](difference_type offset) const;
+
+                const_iterator &operator++();
+                const_iterator &operator--();
+                const_iterator operator++(int);
+                const_iterator operator--(int);
+                const_iterator &operator+=(difference_type offset);
+                const_iterator &operator-=(difference_type offset);
+                const_iterator operator+(difference_type offset) const;
+                const_iterator operator-(difference_type offset) const;
+                difference_type operator-(const const_iterator &rhs) const;
+
+                bool operator==(const const_iterator &rhs) const;
+                bool operator!=(const const_iterator &rhs) const;
+                bool operator<(const const_iterator &rhs) const;
+        };
+
     private:
-        std::vector<Value> _values;
+        struct Storage;
+
+        // Empty lists don't have any storage
+        std::shared_ptr<Storage> _storage;
+
+        template <typename... Args>
+        static std::shared_ptr<Storage> makeStorage(Args&&... args);
+
+        const std::pmr::vector<Value> &values() const;
+
+        // Gets storage which isn't shared with any other list, and which owns
+        // its elements
+        Storage &mutate();
+
+        // Gets storage which isn't shared, with a range's elements filled in
+        Storage &expand();
+
+        // Switches to storing full Values, so that any value can be added
+        std::pmr::vector<Value> &promote();
+
+        // Switches to storing the elements in a rope
+        Rope &makeRope();
 
     public:
         List();
+        explicit List(Bytes bytes);
+        explicit List(Range range);
+        explicit List(Mapped mapped);
         ~List();
-        
+
         List(const List &) = default;
         List(List &&) = default;
         List& operator=(const List &) = default;
@@ -23,23 +156,37 @@ class List {
 
         void add(Value val);
         void concat(const List &);
-        void insert(std::vector<Value>::iterator it, Value value);
+        void prepend(Value value);
         Value pop();
         void clear();
         void reverse();
 
-        std::vector<Value>::iterator begin();
-        std::vector<Value>::iterator end();
-        std::vector<Value>::const_iterator begin() const;
-        std::vector<Value>::const_iterator end() const;
+        // Moves the element at index out of the list, leaving it unspecified
+        Value take(size_t index);
+
+        // Keeps the first index elements in the list, and returns the rest
+        List splitAt(size_t index);
+
+        const_iterator begin() const;
+        const_iterator end() const;
 
-        Value& operator[](size_t index);
         const Value& operator[](size_t index) const;
 
-        Value &back();
         const Value &back() const;
         size_t size() const;
         bool empty() const;
+
+        // Whether the list is stored as a byte string, either its own or
+        // Mapped, and its bytes if so
+        bool isBytes() const;
+        ByteView getBytes() const;
+
+        // Whether the list is stored as a range, and the range if so
+        bool isRange() const;
+        const Range &getRange() const;
+
+        // Whether the list is stored as a rope
+        bool isRope() const;
 };
 
 } // namespace gs2
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+namespace gs2 {
+
+// An arbitrary precision integer. Numbers which fit in 64 bits are kept
+// inline, and only get promoted to a cpp_int when an operation overflows.
+// Results which fit back into 64 bits are demoted again, so the fast path is
+// taken whenever it can be.
+class Number {
+    public:
+        using BigType = boost::multiprecision::cpp_int;
+
+    private:
+        std::variant<int64_t, BigType> _data;
+
+        bool isSmall() const;
+        int64_t small() const;
+        BigType big() const;
+
+        // Switches back to the inline representation if the number fits
+        void demote();
+
+    public:
+        Number();
+        Number(int64_t num);
+        Number(BigType num);
+        explicit Number(const std::string &str);
+
+        // Any other integer type, which needs care for unsigned numbers too
+        // big for an int64_t
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        Number(T num);
+
+        Number &operator+=(const Number &rhs);
+        Number &operator-=(const Number &rhs);
+        Number &operator*=(const Number &rhs);
+        Number &operator/=(const Number &rhs);
+        Number &operator%=(const Number &rhs);
+        Number &operator++();
+        Number &operator--();
+        Number operator++(int);
+        Number operator--(int);
+
+        friend Number operator+(Number lhs, const Number &rhs) { return lhs += rhs; }
+        friend Number operator-(Number lhs, const Number &rhs) { return lhs -= rhs; }
+        friend Number operator*(Number lhs, const Number &rhs) { return lhs *= rhs; }
+        friend Number operator/(Number lhs, const Number &rhs) { return lhs /= rhs; }
+        friend Number operator%(Number lhs, const Number &rhs) { return lhs %= rhs; }
+
+        friend int compare(const Number &lhs, const Number &rhs);
+        friend bool operator==(const Number &lhs, const Number &rhs) { return compare(lhs, rhs) == 0; }
+        friend bool operator!=(const Number &lhs, const Number &rhs) { return compare(lhs, rhs) != 0; }
+        friend bool operator<(const Number &lhs, const Number &rhs)  { return compare(lhs, rhs) < 0; }
+        friend bool operator<=(const Number &lhs, const Number &rhs) { return compare(lhs, rhs) <= 0; }
+        friend bool operator>(const Number &lhs, const Number &rhs)  { return compare(lhs, rhs) > 0; }
+        friend bool operator>=(const Number &lhs, const Number &rhs) { return compare(lhs, rhs) >= 0; }
+
+        explicit operator bool() const;
+
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        explicit operator T() const;
+
+        // Whether the number is stored inline, rather than as a cpp_int
+        bool fitsInt64() const;
+
+        std::string str() const;
+};
+
+// Overflow-checked arithmetic on 64 bit integers, returning false if the
+// result doesn't fit
+bool checkedAdd(int64_t x, int64_t y, int64_t &result);
+bool checkedSub(int64_t x, int64_t y, int64_t &result);
+bool checkedMul(int64_t x, int64_t y, int64_t &result);
+
+template <typename T, typename>
+Number::Number(T num) {
+    if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(int64_t)) {
+        if (num > static_cast<T>(std::numeric_limits<int64_t>::max())) {
+            _data = BigType(num);
+            return;
+        }
+    }
+    _data = static_cast<int64_t>(num);
+}
+
+// Numbers which don't fit in T are narrowed by the cpp_int conversion however
+// they're stored, so that both saturate the same way
+template <typename T, typename>
+Number::operator T() const {
+    if (isSmall()) {
+        auto value = small();
+        bool fits;
+        if constexpr (std::is_signed_v<T>) {
+            fits = value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+        }
+        else {
+            fits = value >= 0 && static_cast<uint64_t>(value) <= std::numeric_limits<T>::max();
+        }
+
+        if (fits) {
+            return static_cast<T>(value);
+        }
+        return static_cast<T>(BigType(value));
+    }
+    return static_cast<T>(std::get<BigType>(_data));
+}
+
+} // namespace gs2
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace gs2 {
+
+struct Instruction;
+
+// How many times each of the optimizer's rewrites was applied
+struct OptimizationReport {
+    size_t foldedConstants = 0;
+    size_t removedPushPops = 0;
+    size_t removedDupPops = 0;
+    size_t inlinedBlocks = 0;
+};
+
+// Rewrites the blocks of a compiled program. At level 1 this folds
+// arithmetic on number literals, removes values which are pushed only to be
+// popped, and inlines block literals which are immediately evaluated. Level 2
+// also removes dup-then-pop pairs, which would otherwise fail on an empty
+// stack.
+void optimize(std::vector<Instruction> &code, std::vector<size_t> &blockStarts,
+              int level, OptimizationReport &report);
+
+} // namespace gs2
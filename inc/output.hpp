@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace gs2 {
+
+class Value;
+
+// Writes values to a file descriptor the same way Value::str would print
+// them, but straight into a buffer which is written out whenever it fills
+// up, so that no strings are built along the way. Anything still buffered is
+// written out when the output is destroyed.
+class Output {
+    private:
+        int _fd;
+        std::vector<char> _buffer;
+        size_t _used;
+
+        // Set once a write fails, after which nothing more is written
+        bool _failed;
+
+        void writeNested(const Value &value);
+        void writeAll(const char *data, size_t size);
+
+    public:
+        explicit Output(int fd);
+        ~Output();
+
+        Output(const Output &) = delete;
+        Output &operator=(const Output &) = delete;
+
+        // Throws without writing anything if the value contains a block
+        void write(const Value &value);
+
+        // Writes characters as they are
+        void put(char c);
+        void put(const char *data, size_t size);
+
+        void flush();
+};
+
+} // namespace gs2
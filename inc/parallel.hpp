@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace gs2 {
+
+class Block;
+
+// Whether running the block can't affect anything besides the single value
+// it's given: it never pops or looks at anything below that value, doesn't
+// use the counter, and can't push or run blocks. Map can run a pure block on
+// many elements at once, as long as none of them contain blocks either.
+bool isPureBlock(const Block &block);
+
+// The number of threads to use when asked for 0, which is one per core
+size_t defaultThreadCount();
+
+// Calls fn with every index in [0, count), split into chunks which are
+// spread across up to threads threads, including the calling one. Returns
+// once every call has finished. If any calls throw, the exception thrown
+// for the lowest index is rethrown, the same as if they'd run in order.
+void parallelFor(size_t count, size_t threads, const std::function<void(size_t)> &fn);
+
+// Reduces the indexes [0, count) as a balanced tree. leaf(begin, end) works
+// out the result for a run of neighbouring indexes, and op(lhs, rhs) then
+// merges rhs into lhs, pairing up neighbours until only one result is left.
+// op has to be associative, but it's always given its operands in order, so
+// it needn't be commutative. Keeping the operands of each op about the same
+// size makes this much faster than going left to right for things like
+// bigint products, even on one thread. count can't be 0.
+template <typename T, typename Leaf, typename Op>
+T treeReduce(size_t count, size_t threads, Leaf leaf, Op op) {
+    constexpr size_t LEAF_SIZE = 64;
+
+    // Short reductions aren't worth handing out to other threads
+    constexpr size_t PARALLEL_THRESHOLD = 4096;
+    if (count < PARALLEL_THRESHOLD) {
+        threads = 1;
+    }
+
+    std::vector<T> results((count + LEAF_SIZE - 1) / LEAF_SIZE);
+    parallelFor(results.size(), threads, [&] (size_t i) {
+        results[i] = leaf(i * LEAF_SIZE, std::min(count, (i + 1) * LEAF_SIZE));
+    });
+
+    // Each pass merges results stride apart, leaving them at multiples of
+    // twice the stride, so no two merges touch the same result
+    for (size_t stride = 1; stride < results.size(); stride *= 2) {
+        auto pairs = (results.size() - stride + 2 * stride - 1) / (2 * stride);
+        parallelFor(pairs, threads, [&] (size_t pair) {
+            auto i = pair * 2 * stride;
+            op(results[i], std::move(results[i + stride]));
+        });
+    }
+
+    return std::move(results[0]);
+}
+
+} // namespace gs2
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+namespace gs2 {
+
+// The name a command byte is reported under, like "mod / step / clean-split
+// / map", or "push-number" for the bytes which push small numbers
+std::string describeCommand(uint8_t byte);
+
+// Counts how many times each command byte is run and how long it takes, for
+// --profile. The time for a command is only its own, since the blocks it runs
+// are run by the interpreter once it returns, and their commands are counted
+// separately. The helpers which run blocks for commands, like do_map, are
+// also counted by name, along with the time they spend between running the
+// block, like collecting up the results.
+class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry {
+            uint64_t count = 0;
+            Clock::duration time{};
+        };
+
+    private:
+        std::array<Entry, 256> _commands;
+        std::map<std::string, Entry> _helpers;
+
+    public:
+        void addCommand(uint8_t byte, Clock::duration time);
+
+        // Helpers which are called once and then step through a loop are
+        // only counted the first time
+        void addHelper(const char *name, Clock::duration time, bool counted = true);
+
+        const Entry &getCommand(uint8_t byte) const;
+        Entry getHelper(const std::string &name) const;
+
+        // Prints the commands and then the helpers, slowest first
+        void report(std::ostream &out) const;
+};
+
+// Adds the time until it's destroyed to a helper, if there's a profiler
+class ProfileScope {
+    private:
+        Profiler *_profiler;
+        const char *_name;
+        bool _counted;
+        Profiler::Clock::time_point _start;
+
+    public:
+        ProfileScope(Profiler *profiler, const char *name, bool counted = true);
+        ~ProfileScope();
+
+        ProfileScope(const ProfileScope &) = delete;
+        ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+} // namespace gs2
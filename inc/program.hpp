@@ -0,0 +1,72 @@
+#pragma once
+
+#include "block.hpp"
+#include "commands.hpp"
+#include "optimizer.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gs2 {
+
+class GS2Context;
+
+enum class Op: uint8_t {
+    PushNumber,
+    PushConstants,
+    PushBlock,
+    Call,
+    BadCommand,
+    BadStringEnd,
+    Return,
+};
+
+// A single pre-decoded instruction. Depending on the op, the operands are:
+//  * PushNumber: the number to push is in immediate
+//  * PushConstants: constants [operand, operand + immediate) are pushed in order
+//  * PushBlock: the index of the block to push is in operand
+//  * Call: the function implementing the command is in command
+// offset is where the instruction's command starts in the source file.
+struct Instruction {
+    Op op;
+    uint8_t byte;
+    uint32_t operand;
+    int64_t immediate;
+    CommandFn command;
+    uint32_t offset;
+};
+
+// A block, along with all of the blocks nested inside of it, compiled into
+// one contiguous array of instructions. Every block is terminated by a Return
+// instruction, and blocks refer to the blocks nested in them by index.
+// Values which never change, like string literals, are built once when the
+// program is compiled and kept in a constant pool.
+class Program: public std::enable_shared_from_this<Program> {
+    private:
+        std::vector<Instruction> _code;
+        std::vector<size_t> _blockStarts;
+        std::vector<const Block *> _blockSources;
+        std::vector<Value> _constants;
+
+        Block _source;
+
+        void compileBlock(const Block &block);
+        void addConstant(Instruction &insn, Value value);
+
+    public:
+        static std::shared_ptr<const Program> compile(const Block &block,
+                                                      int optimizationLevel = 0,
+                                                      OptimizationReport *report = nullptr);
+
+        void execute(GS2Context &gs2, size_t blockIndex = 0) const;
+
+        const std::vector<Instruction> &getCode() const;
+        size_t getBlockCount() const;
+        size_t getBlockStart(size_t blockIndex) const;
+        const Block &getSource(size_t blockIndex) const;
+        const Value &getConstant(size_t constantIndex) const;
+};
+
+} // namespace gs2
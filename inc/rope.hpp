@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace gs2 {
+
+class Value;
+
+// A persistent sequence of values, stored as a height-balanced tree whose
+// leaves hold short runs of elements, or of bytes for elements which came
+// from byte strings. Copies share their nodes, and every
+// operation builds new nodes along one path instead of changing shared ones,
+// so concatenating, prepending, splitting and indexing are all O(log n).
+class Rope {
+    private:
+        struct Node;
+
+        // Empty ropes don't have any nodes
+        std::shared_ptr<Node> _root;
+
+        explicit Rope(std::shared_ptr<Node> root);
+
+    public:
+        Rope();
+        explicit Rope(std::pmr::vector<Value> values);
+        explicit Rope(const std::pmr::vector<uint8_t> &bytes);
+        ~Rope();
+
+        Rope(const Rope &) = default;
+        Rope(Rope &&) = default;
+        Rope& operator=(const Rope &) = default;
+        Rope& operator=(Rope &&) = default;
+
+        void append(Value value);
+        void prepend(Value value);
+        void concat(const Rope &rope);
+
+        // Keeps the first index elements, and returns the rest
+        Rope splitAt(size_t index);
+
+        const Value &operator[](size_t index) const;
+        size_t size() const;
+
+        std::pmr::vector<Value> values() const;
+};
+
+} // namespace gs2
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gs2 {
+
+// One level of where a program was when it was sampled: either a command,
+// by its byte and where it starts in the source file, or, when helper isn't
+// null, a loop which a helper like do_map is running a block with
+struct SampleFrame {
+    uint8_t byte;
+    size_t offset;
+    const char *helper;
+};
+
+// Samples where a program is, for --sample. A timer signal fires every
+// interval of CPU time, and all the handler does is mark a sample as due.
+// The interpreter checks for that between instructions, and records the
+// instruction which just ran, along with the commands running the blocks
+// it's nested in. Only one sampler can be running at a time, and sampling
+// isn't supported on Windows.
+class Sampler {
+    private:
+        std::map<std::string, uint64_t> _stacks;
+        std::map<std::pair<size_t, uint8_t>, uint64_t> _offsets;
+        uint64_t _total;
+
+    public:
+        explicit Sampler(std::chrono::microseconds interval);
+        ~Sampler();
+
+        Sampler(const Sampler &) = delete;
+        Sampler &operator=(const Sampler &) = delete;
+
+        // Whether the timer has fired since the last sample was taken
+        static bool isDue();
+
+        // Records a sample, outermost frame first, and clears isDue
+        void record(const std::vector<SampleFrame> &path);
+
+        uint64_t getTotal() const;
+
+        // Writes each distinct path and how many samples it had, in the
+        // folded stack format which flame graph tools take
+        void writeFolded(std::ostream &out) const;
+
+        // Prints the source offsets which were running when the most samples
+        // were taken, most first
+        void report(std::ostream &out, size_t limit = 20) const;
+};
+
+} // namespace gs2
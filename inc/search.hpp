@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace gs2 {
+
+// Finds the first occurrence of byte in [begin, end), or returns end if there
+// isn't one. Uses AVX2 or SSE2 when the CPU running the program supports
+// them.
+const uint8_t *findByte(const uint8_t *begin, const uint8_t *end, uint8_t byte);
+
+// For each prefix of pattern, the length of the longest proper prefix of it
+// which is also a suffix of it. Elements are only compared with operator!=.
+template <typename Seq>
+std::vector<size_t> prefixTable(const Seq &pattern, size_t size) {
+    std::vector<size_t> table(size, 0);
+    size_t length = 0;
+
+    for (size_t i = 1; i < size; i++) {
+        while (length > 0 && pattern[i] != pattern[length]) {
+            length = table[length - 1];
+        }
+        if (!(pattern[i] != pattern[length])) {
+            length++;
+        }
+        table[i] = length;
+    }
+
+    return table;
+}
+
+// Calls found with the index of each place pattern occurs in text, from left
+// to right and without overlapping, using the Knuth-Morris-Pratt algorithm so
+// that it takes O(n + m) time whatever the pattern is. For byte strings, the
+// first byte of the pattern is found with findByte.
+template <typename Seq, typename Fn>
+void findEach(const Seq &text, size_t textSize, const Seq &pattern, size_t patternSize, Fn found) {
+    if (patternSize == 0) {
+        return;
+    }
+
+    auto table = prefixTable(pattern, patternSize);
+    size_t matched = 0;
+
+    for (size_t i = 0; i < textSize; i++) {
+        if constexpr (std::is_same_v<Seq, const uint8_t *>) {
+            if (matched == 0) {
+                i = findByte(text + i, text + textSize, pattern[0]) - text;
+                if (i == textSize) {
+                    return;
+                }
+            }
+        }
+
+        while (matched > 0 && text[i] != pattern[matched]) {
+            matched = table[matched - 1];
+        }
+        if (!(text[i] != pattern[matched])) {
+            matched++;
+        }
+
+        if (matched == patternSize) {
+            found(i + 1 - patternSize);
+            matched = 0;
+        }
+    }
+}
+
+} // namespace gs2
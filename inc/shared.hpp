@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace gs2 {
+
+// Whether pointer is the only owner of what it points to, so that it can be
+// changed in place. use_count() is only a relaxed load, so on its own it
+// doesn't make what other owners did before letting go, maybe on another
+// thread, visible to this one. The fence makes it so.
+//
+// ThreadSanitizer doesn't see fences, so under it nothing counts as unique
+// and everything is copied instead; races elsewhere still get reported.
+template <typename T>
+bool isUnique(const std::shared_ptr<T> &pointer) {
+#if defined(__SANITIZE_THREAD__)
+    (void)pointer;
+    return false;
+#else
+    if (pointer.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+#endif
+}
+
+} // namespace gs2
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace gs2 {
 
 class List;
+class Number;
 class Value;
 
 List makeList(const std::string &str);
@@ -17,4 +20,12 @@ List split(List toSplit, const List &sep, bool clean = false);
 
 List stepOver(List list, int64_t stepSize);
 
+// The sum and product of a list of numbers, worked out as a balanced tree
+// spread across up to threads threads
+Number sumList(const List &list, size_t threads = 1);
+Number productList(const List &list, size_t threads = 1);
+
+// Whether the value is a block, or a list with a block anywhere inside it
+bool containsBlock(const Value &value);
+
 } // namespace gs2
@@ -2,8 +2,7 @@
 
 #include "block.hpp"
 #include "list.hpp"
-
-#include <boost/multiprecision/cpp_int.hpp>
+#include "number.hpp"
 
 #include <cstdint>
 #include <string>
@@ -13,7 +12,7 @@ namespace gs2 {
 
 class Value {
     public:
-        using IntType = boost::multiprecision::cpp_int;
+        using IntType = Number;
 
     private:
         std::variant<IntType, List, Block> _data;
@@ -41,4 +40,11 @@ class Value {
         std::string str(bool nested=false) const;
 };
 
+// Byte strings don't store Values, so reading an element gives back one of
+// these instead
+const Value &byteValue(uint8_t byte);
+
+// Whether a value is a number which fits in a byte string
+bool isByte(const Value &value);
+
 } // namespace gs2
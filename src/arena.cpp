@@ -0,0 +1,14 @@
+#include "arena.hpp"
+
+namespace gs2 {
+
+Arena::Arena():
+    _pool(std::pmr::new_delete_resource()),
+    _previous(std::pmr::set_default_resource(&_pool))
+{}
+
+Arena::~Arena() {
+    std::pmr::set_default_resource(_previous);
+}
+
+} // namespace gs2
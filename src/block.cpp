@@ -1,7 +1,13 @@
 #include "block.hpp"
 #include "command.hpp"
+#include "gs2context.hpp"
 #include "gs2exception.hpp"
+#include "interpreter.hpp"
+#include "program.hpp"
+#include "shared.hpp"
 
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 
 namespace gs2 {
@@ -52,31 +58,70 @@ size_t stringLength(const std::vector<uint8_t> &code, size_t start) {
 
 } // anonymous namespace
 
-Block::Block() {}
+struct Block::Node {
+    // For a concatenation, the commands are only filled in when needed
+    mutable std::vector<Command> commands;
+    mutable std::once_flag flattened;
 
-Block::Block(const Block &block): _commands(block._commands) {}
+    bool isConcatenation = false;
+    Block first;
+    Block second;
 
-Block::Block(Block &&block): _commands(std::move(block._commands)) {}
+    mutable std::shared_ptr<const Program> program;
+    mutable std::once_flag compiled;
+};
 
-Block& Block::operator=(const Block &block) {
-    _commands = block._commands;
-    return *this;
-}
+Block::Block(): _index(0) {}
 
-Block& Block::operator=(Block &&block) {
-    _commands = std::move(block._commands);
-    return *this;
-}
+Block::Block(std::shared_ptr<const Program> program, size_t index):
+    _program(std::move(program)),
+    _index(index)
+{}
+
+Block::Block(const Block &block) = default;
+
+Block::Block(Block &&block) noexcept = default;
+
+Block& Block::operator=(const Block &block) = default;
+
+Block& Block::operator=(Block &&block) noexcept = default;
+
+Block::~Block() {
+    // Letting a long chain of concatenations destroy itself would recurse once
+    // per link, so the nodes nobody else holds are taken apart here instead
+    if (!_node || !_node->isConcatenation || !isUnique(_node)) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<Node>> unlinked;
+    unlinked.push_back(std::move(_node));
 
-Block::~Block() {}
+    while (!unlinked.empty()) {
+        auto node = std::move(unlinked.back());
+        unlinked.pop_back();
+
+        for (auto child: {&node->first, &node->second}) {
+            if (child->_node && child->_node->isConcatenation && isUnique(child->_node)) {
+                unlinked.push_back(std::move(child->_node));
+            }
+        }
+    }
+}
 
 bool Block::operator!=(const Block &rhs) const {
-    if (_commands.size() != rhs._commands.size()) {
+    if (_node == rhs._node && _program == rhs._program && _index == rhs._index) {
+        return false;
+    }
+
+    auto &commands = getCommands();
+    auto &rhsCommands = rhs.getCommands();
+
+    if (commands.size() != rhsCommands.size()) {
         return true;
     }
 
-    for (size_t i = 0; i < rhs._commands.size(); i++) {
-        if (_commands[i] != rhs._commands[i]) {
+    for (size_t i = 0; i < rhsCommands.size(); i++) {
+        if (commands[i] != rhsCommands[i]) {
             return true;
         }
     }
@@ -84,31 +129,53 @@ bool Block::operator!=(const Block &rhs) const {
     return false;
 }
 
+bool Block::isLineMode(const std::vector<uint8_t> &code) {
+    return getFileMode(code).second == FileMode::LineMode;
+}
+
 Block Block::parseBytes(const std::vector<uint8_t> &code) {
+    auto block = parseBody(code);
+
+    if (isLineMode(code)) {
+        Block finalBlock;
+        finalBlock.add(Command({0x2a}));
+        finalBlock.add(std::move(block));
+        finalBlock.add(Command({0x34}));
+        finalBlock.add(Command({0x54}));
+        return finalBlock;
+    }
+    else {
+        return block;
+    }
+}
+
+Block Block::parseBody(const std::vector<uint8_t> &code) {
     std::vector<Block> blocks;
     std::vector<Command> final;
 
     blocks.emplace_back();
 
-    auto [startIndex, mode] = getFileMode(code);
+    auto startIndex = getFileMode(code).first;
 
     if (auto stringEnd = findUnstartedString(code, startIndex); stringEnd) {
         std::vector<uint8_t> string = { STRING_START_CMD };
         string.insert(string.end(), code.begin() + startIndex, code.begin() + *stringEnd + 1);
-        blocks.back().add(Command{std::move(string)});
+        blocks.back().add(Command{std::move(string), startIndex});
         startIndex = *stringEnd + 1;
     }
 
-    auto openBlock = [&] (uint8_t cmdByte) {
+    // Both the block and the command which finishes it are placed where the
+    // block was opened
+    auto openBlock = [&] (uint8_t cmdByte, size_t offset) {
         blocks.emplace_back();
-        final.emplace_back(std::vector<uint8_t>{cmdByte});
+        final.emplace_back(std::vector<uint8_t>{cmdByte}, offset);
     };
 
     auto closeBlock = [&] {
         if (blocks.size() < 2) {
             throw GS2Exception{"Cannot close an unopened block!"};
         }
-        blocks[blocks.size() - 2].add(std::move(blocks.back()));
+        blocks[blocks.size() - 2].add(Command{std::move(blocks.back()), final.back().getOffset()});
         blocks.pop_back();
         blocks.back().add(std::move(final.back()));
         final.pop_back();
@@ -123,7 +190,7 @@ Block Block::parseBytes(const std::vector<uint8_t> &code) {
             }
 
             std::vector<uint8_t> cmd{code.begin() + i, code.begin() + cmdLen + i};
-            blocks.back().add(Command{std::move(cmd)});
+            blocks.back().add(Command{std::move(cmd), i});
             i += cmdLen - 1;
         };
 
@@ -149,15 +216,15 @@ Block Block::parseBytes(const std::vector<uint8_t> &code) {
                 break;
 
             case BLOCK_START_CMD:
-                openBlock(0x00);
+                openBlock(0x00, i);
                 break;
 
             case MAP_BLOCK_CMD:
-                openBlock(0x34);
+                openBlock(0x34, i);
                 break;
 
             case FILTER_BLOCK_CMD:
-                openBlock(0x35);
+                openBlock(0x35, i);
                 break;
 
             case BLOCK_END_CMD:
@@ -174,37 +241,136 @@ Block Block::parseBytes(const std::vector<uint8_t> &code) {
         closeBlock();
     }
 
-    auto block = std::move(blocks[0]);
+    return std::move(blocks[0]);
+}
 
-    if (mode == FileMode::LineMode) {
-        Block finalBlock;
-        finalBlock.add(Command({0x2a}));
-        finalBlock.add(std::move(block));
-        finalBlock.add(Command({0x34}));
-        finalBlock.add(Command({0x54}));
-        return finalBlock;
+template <typename Fn>
+void Block::forEachPiece(Fn fn) const {
+    if (!_node || !_node->isConcatenation) {
+        fn(*this);
+        return;
     }
-    else {
-        return block;
+
+    // Long chains of concatenations are walked without recursion
+    std::vector<const Block *> pending{this};
+
+    while (!pending.empty()) {
+        auto block = pending.back();
+        pending.pop_back();
+
+        if (block->_node && block->_node->isConcatenation) {
+            pending.push_back(&block->_node->second);
+            pending.push_back(&block->_node->first);
+        }
+        else {
+            fn(*block);
+        }
     }
 }
 
 void Block::execute(GS2Context &gs2) const {
-    for (const auto &command: _commands) {
-        command.execute(gs2);
+    if (gs2.getEngine() != Engine::TreeWalker || gs2.getProfiler() || gs2.getSampler()) {
+        gs2.getInterpreter().run(gs2, *this);
+        return;
     }
+
+    forEachPiece([&gs2] (const Block &piece) {
+        for (const auto &command: piece.getCommands()) {
+            command.execute(gs2);
+        }
+    });
 }
 
 void Block::add(Command command) {
-    _commands.emplace_back(std::move(command));
+    // Nobody else can see an unshared, uncompiled node, so it's still safe to
+    // modify it
+    if (_node && !_node->isConcatenation && !_node->program && isUnique(_node)) {
+        _node->commands.emplace_back(std::move(command));
+        return;
+    }
+
+    auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{});
+    node->commands = getCommands();
+    node->commands.emplace_back(std::move(command));
+
+    _node = std::move(node);
+    _program.reset();
+    _index = 0;
 }
 
 void Block::concat(const Block &block) {
-    _commands.insert(_commands.end(), block._commands.begin(), block._commands.end());
+    if (!block._node && !block._program) {
+        return;
+    }
+
+    if (!_node && !_program) {
+        *this = block;
+        return;
+    }
+
+    auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{});
+    node->isConcatenation = true;
+    node->first = std::move(*this);
+    node->second = block;
+
+    _node = std::move(node);
+    _program.reset();
+    _index = 0;
 }
 
 const std::vector<Command> &Block::getCommands() const {
-    return _commands;
+    static const std::vector<Command> noCommands;
+
+    if (_program) {
+        return _program->getSource(_index).getCommands();
+    }
+    else if (!_node) {
+        return noCommands;
+    }
+
+    if (_node->isConcatenation) {
+        std::call_once(_node->flattened, [this] {
+            forEachPiece([this] (const Block &piece) {
+                auto &commands = piece.getCommands();
+                _node->commands.insert(_node->commands.end(), commands.begin(), commands.end());
+            });
+        });
+    }
+
+    return _node->commands;
+}
+
+bool Block::isConcatenation() const {
+    return _node && _node->isConcatenation;
+}
+
+const Block &Block::getFirst() const {
+    return _node->first;
+}
+
+const Block &Block::getSecond() const {
+    return _node->second;
+}
+
+const Program &Block::getProgram() const {
+    if (_program) {
+        return *_program;
+    }
+
+    if (!_node) {
+        static const auto emptyProgram = Program::compile(Block{});
+        return *emptyProgram;
+    }
+
+    std::call_once(_node->compiled, [this] {
+        _node->program = Program::compile(*this);
+    });
+
+    return *_node->program;
+}
+
+size_t Block::getProgramIndex() const {
+    return _program ? _index : 0;
 }
 
 } // namespace gs2
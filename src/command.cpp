@@ -31,12 +31,14 @@ List splitString(std::vector<uint8_t>::const_iterator begin,
 
 } // anonymous namespace
 
-Command::Command(std::vector<uint8_t> bytes):
-    _command(std::move(bytes))
+Command::Command(std::vector<uint8_t> bytes, size_t offset):
+    _command(std::move(bytes)),
+    _offset(offset)
 {}
 
-Command::Command(Block block):
-    _command(std::move(block))
+Command::Command(Block block, size_t offset):
+    _command(std::move(block)),
+    _offset(offset)
 {}
 
 bool Command::operator!=(const Command &rhs) const {
@@ -100,8 +102,8 @@ void Command::executeBytes(const std::vector<uint8_t> &bytes, GS2Context &gs2) {
 
             switch (bytes.back()) {
                 case 0x05:
-                    for (auto &string: strings) {
-                        gs2.push(std::move(string));
+                    for (size_t i = 0; i < strings.size(); i++) {
+                        gs2.push(strings.take(i));
                     }
                     break;
 
@@ -124,10 +126,6 @@ void Command::executeBytes(const std::vector<uint8_t> &bytes, GS2Context &gs2) {
             break;
         }
 
-        case 0x0a: newLine(gs2);           break;
-        case 0x0b: emptyList(gs2);         break;
-        case 0x0c: emptyBlock(gs2);        break;
-        case 0x0d: space(gs2);             break;
         case 0x10: gs2.push(0);            break;
         case 0x11: gs2.push(1);            break;
         case 0x12: gs2.push(2);            break;
@@ -144,38 +142,12 @@ void Command::executeBytes(const std::vector<uint8_t> &bytes, GS2Context &gs2) {
         case 0x1d: gs2.push(16);           break;
         case 0x1e: gs2.push(64);           break;
         case 0x1f: gs2.push(256);          break;
-        case 0x20: negate(gs2);            break;
-        case 0x21: head(gs2);              break;
-        case 0x22: tail(gs2);              break;
-        case 0x23: abs(gs2);               break;
-        case 0x24: last(gs2);              break;
-        case 0x2a: lines(gs2);             break;
-        case 0x2b: unlines(gs2);           break;
-        case 0x2e: range(gs2);             break;
-        case 0x2f: range1(gs2);            break;
-        case 0x30: catenate(gs2);          break;
-        case 0x32: fold(gs2);              break;
-        case 0x34: mod(gs2);               break;
-        case 0x40: dup(gs2);               break;
-        case 0x41: dup2(gs2);              break;
-        case 0x50: pop(gs2);               break;
-        case 0x51: pop2(gs2);              break;
-        case 0x52: show(gs2);              break;
-        case 0x54: showLines(gs2);         break;
-        case 0x55: showWords(gs2);         break;
-        case 0x56: readNum(gs2);           break;
-        case 0x57: readNums(gs2);          break;
-        case 0x58: showLine(gs2);          break;
-        case 0x59: showSpace(gs2);         break;
-        case 0x64: sum(gs2);               break;
-        case 0x65: product(gs2);           break;
-        case 0x84: uppercaseAlphabet(gs2); break;
-        case 0x85: lowercaseAlphabet(gs2); break;
-        case 0x86: asciiDigits(gs2);       break;
-        case 0x87: printableAscii(gs2);    break;
-        case 0xb2: counter(gs2);           break;
 
         default:
+            if (auto command = findCommand(bytes[0]); command) {
+                command(gs2);
+                break;
+            }
             throw GS2Exception{"Unhandled command byte: " + std::to_string(bytes[0])};
     }
 }
@@ -196,6 +168,10 @@ const Block& Command::getBlock() const {
     return std::get<Block>(_command);
 }
 
+size_t Command::getOffset() const {
+    return _offset;
+}
+
 bool isStringEnd(const uint8_t byte) {
     return byte == 0x05 || byte == 0x06 || (byte >= 0x9b && byte <= 0x9f);
 }
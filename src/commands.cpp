@@ -4,10 +4,81 @@
 #include "utils.hpp"
 
 #include <cassert>
-#include <regex>
+#include <optional>
+#include <string>
 
 namespace gs2 {
 
+namespace {
+
+// The numbers [start, end), without building any of them
+List makeRange(int64_t start, const Value::IntType &end) {
+    if (end <= start) {
+        return List{};
+    }
+    if (!end.fitsInt64()) {
+        throw GS2Exception{"Range is too large!"};
+    }
+
+    auto count = static_cast<int64_t>(end) - start;
+    return List{List::Range{start, 1, static_cast<size_t>(count)}};
+}
+
+// The characters of a value, read straight out of the list when it's a byte
+// string, or converted into str otherwise
+std::pair<const uint8_t *, const uint8_t *> getChars(const Value &value, std::string &str) {
+    if (value.isList() && value.getList().isBytes()) {
+        const auto &bytes = value.getList().getBytes();
+        return {bytes.data(), bytes.data() + bytes.size()};
+    }
+
+    str = makeString(value);
+    auto data = reinterpret_cast<const uint8_t *>(str.data());
+    return {data, data + str.size()};
+}
+
+bool isDigit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+// Finds the next number at or after pos, which is a run of digits along with
+// a minus sign right before it, and moves pos past it. Digits are read 18 at
+// a time into an int64_t, so only numbers longer than that do any bigint
+// arithmetic.
+std::optional<Value::IntType> scanNumber(const uint8_t *&pos, const uint8_t *begin, const uint8_t *end) {
+    while (pos != end && !isDigit(*pos)) {
+        ++pos;
+    }
+    if (pos == end) {
+        return std::nullopt;
+    }
+
+    bool negative = pos != begin && pos[-1] == '-';
+    Value::IntType number;
+
+    for (bool first = true; pos != end && isDigit(*pos); first = false) {
+        int64_t chunk = 0;
+        int64_t scale = 1;
+
+        for (int i = 0; i < 18 && pos != end && isDigit(*pos); i++, ++pos) {
+            chunk = chunk * 10 + (*pos - '0');
+            scale *= 10;
+        }
+
+        if (first) {
+            number = negative ? -chunk : chunk;
+        }
+        else {
+            number *= scale;
+            number += negative ? -chunk : chunk;
+        }
+    }
+
+    return number;
+}
+
+} // anonymous namespace
+
 // 0x22 - abs / init
 void abs(GS2Context &gs2) {
     auto value = gs2.pop();
@@ -61,7 +132,7 @@ void catenate(GS2Context &gs2) {
         gs2.push(std::move(x));
     }
     else if (y.isList()) {
-        y.getList().insert(y.getList().begin(), std::move(x));
+        y.getList().prepend(std::move(x));
         gs2.push(std::move(y));
     }
     else {
@@ -120,32 +191,16 @@ void fold(GS2Context &gs2) {
 
         List multipliedList;
         while (num-- > 0) {
-            for (const auto &val: list) {
-                multipliedList.add(val);
-            }
+            multipliedList.concat(list);
         }
 
         gs2.push(std::move(multipliedList));
     }
     else if (x.isBlock() && y.isNumber()) {
-        auto &num = y.getNumber();
-        auto &block = x.getBlock();
-        while (num-- > 0) {
-            block.execute(gs2);
-        }
+        gs2.times(x.getBlock(), std::move(y.getNumber()));
     }
     else if (x.isList() && y.isBlock()) {
-        auto &list = x.getList();
-        auto &block = y.getBlock();
-
-        if (list.empty()) {
-            throw GS2Exception{"Cannot fold an empty list!"};
-        }
-        gs2.push(std::move(list[0]));
-        for (auto it = list.begin() + 1; it != list.end(); ++it) {
-            gs2.push(std::move(*it));
-            block.execute(gs2);
-        }
+        gs2.fold(y.getBlock(), std::move(x.getList()));
     }
     else {
         throw GS2Exception{"Unsupported types for multiply / join / times / fold"};
@@ -167,7 +222,7 @@ void head(GS2Context &gs2) {
         if (list.empty()) {
             throw GS2Exception{"Cannot get the head of an empty list!"};
         }
-        gs2.push(std::move(list[0]));
+        gs2.push(list.take(0));
     }
     else {
         throw GS2Exception{"Unsupported type for bnot / head"};
@@ -209,7 +264,7 @@ void lines(GS2Context &gs2) {
         auto &list = value.getList();
         
         if (!list.empty()) {
-            auto &back = list.back();
+            const auto &back = list[list.size() - 1];
             if (back.isNumber() && back.getNumber() == '\n') {
                 list.pop();
             }
@@ -217,7 +272,7 @@ void lines(GS2Context &gs2) {
 
         List newlineList;
         newlineList.add('\n');
-        gs2.push(split(list, newlineList));
+        gs2.push(split(std::move(list), newlineList));
     }
     else {
         throw GS2Exception{"Unsupported type for double / lines!"};
@@ -247,7 +302,7 @@ void mod(GS2Context &gs2) {
         gs2.push(std::move(x));
     }
     else if (x.isList() && y.isNumber()) {
-        gs2.push(stepOver(std::move(x.getList()), y.getNumber().convert_to<int64_t>()));
+        gs2.push(stepOver(std::move(x.getList()), static_cast<int64_t>(y.getNumber())));
     }
     else if (x.isList() && y.isList()) {
         gs2.push(split(std::move(x.getList()), y.getList(), true));
@@ -274,7 +329,7 @@ void negate(GS2Context &gs2) {
     }
     else {
         assert(value.isBlock());
-        value.getBlock().execute(gs2);
+        gs2.evaluate(value.getBlock());
     }
 }
 
@@ -313,16 +368,7 @@ void product(GS2Context &gs2) {
         gs2.push(val.getNumber() % 2 == 0 ? 0 : 1);
     }
     else if (val.isList()) {
-        Value::IntType sum = 1;
-
-        for (const auto &numVal: val.getList()) {
-            if (!numVal.isNumber()) {
-                throw GS2Exception{"Cannot sum a list with non-numbers!"};
-            }
-            sum *= numVal.getNumber();
-        }
-
-        gs2.push(sum);
+        gs2.push(productList(val.getList(), gs2.getThreads()));
     }
     else {
         throw GS2Exception{"Cannot perform sum/even on a block!"};
@@ -334,14 +380,7 @@ void range(GS2Context &gs2) {
     auto val = gs2.pop();
 
     if (val.isNumber()) {
-        auto &endVal = val.getNumber();
-
-        List list;
-        for (uint64_t i = 0; i < endVal; i++) {
-            list.add(i);
-        }
-
-        gs2.push(std::move(list));
+        gs2.push(makeRange(0, val.getNumber()));
     }
     else if (val.isList()) {
         gs2.push(val.getList().size());
@@ -356,14 +395,7 @@ void range1(GS2Context &gs2) {
     auto val = gs2.pop();
 
     if (val.isNumber()) {
-        auto &endVal = val.getNumber();
-
-        List list;
-        for (uint64_t i = 1; i <= endVal; i++) {
-            list.add(i);
-        }
-
-        gs2.push(std::move(list));
+        gs2.push(makeRange(1, val.getNumber() + 1));
     }
     else {
         throw GS2Exception{"Unsupported types for 0x2f (for now)"};
@@ -372,28 +404,28 @@ void range1(GS2Context &gs2) {
 
 // 0x56 - read-num
 void readNum(GS2Context &gs2) {
-    auto str = makeString(gs2.pop());
-    auto numberRegex = std::regex{"-?[0-9]+"};
-    std::smatch match;
+    auto value = gs2.pop();
+    std::string str;
+    auto [begin, end] = getChars(value, str);
 
-    if (!std::regex_search(str, match, numberRegex)) {
+    auto pos = begin;
+    auto number = scanNumber(pos, begin, end);
+    if (!number) {
         throw GS2Exception{"Unable to read a number!"};
     }
 
-    gs2.push(Value::IntType(match.str()));
+    gs2.push(std::move(*number));
 }
 
 // 0x57 - read-nums
 void readNums(GS2Context &gs2) {
-    auto str = makeString(gs2.pop());
-    auto numberRegex = std::regex{"-?[0-9]+"};
-
-    auto begin = std::sregex_iterator(str.begin(), str.end(), numberRegex);
-    auto end = std::sregex_iterator();
+    auto value = gs2.pop();
+    std::string str;
+    auto [begin, end] = getChars(value, str);
 
     List numbers;
-    for (auto it = begin; it != end; ++it) {
-        numbers.add(Value::IntType(it->str()));
+    for (auto pos = begin; auto number = scanNumber(pos, begin, end);) {
+        numbers.add(std::move(*number));
     }
 
     gs2.push(std::move(numbers));
@@ -476,16 +508,7 @@ void sum(GS2Context &gs2) {
         gs2.push(val.getNumber() % 2 == 0 ? 1 : 0);
     }
     else if (val.isList()) {
-        Value::IntType sum = 0;
-
-        for (const auto &numVal: val.getList()) {
-            if (!numVal.isNumber()) {
-                throw GS2Exception{"Cannot sum a list with non-numbers!"};
-            }
-            sum += numVal.getNumber();
-        }
-
-        gs2.push(sum);
+        gs2.push(sumList(val.getList(), gs2.getThreads()));
     }
     else {
         throw GS2Exception{"Cannot perform sum/even on a block!"};
@@ -504,7 +527,7 @@ void tail(GS2Context &gs2) {
         if (list.empty()) {
             throw GS2Exception{"Cannot get the tail of an empty list!"};
         }
-        gs2.push(std::move(list.back()));
+        gs2.push(list.pop());
     }
     else {
         throw GS2Exception{"Cannot perform not/tail on a block!"};
@@ -527,9 +550,7 @@ void unlines(GS2Context &gs2) {
             if (i > 0) {
                 joined.add('\n');
             }
-            for (auto c: toJoin[i].str()) {
-                joined.add(c);
-            }
+            joined.concat(makeList(toJoin[i].str()));
         }
 
         gs2.push(std::move(joined));
@@ -548,4 +569,84 @@ void uppercaseAlphabet(GS2Context &gs2) {
     gs2.push(std::move(list));
 }
 
+CommandFn findCommand(uint8_t byte) {
+    switch (byte) {
+        case 0x0a: return newLine;
+        case 0x0b: return emptyList;
+        case 0x0c: return emptyBlock;
+        case 0x0d: return space;
+        case 0x20: return negate;
+        case 0x21: return head;
+        case 0x22: return tail;
+        case 0x23: return abs;
+        case 0x24: return last;
+        case 0x2a: return lines;
+        case 0x2b: return unlines;
+        case 0x2e: return range;
+        case 0x2f: return range1;
+        case 0x30: return catenate;
+        case 0x32: return fold;
+        case 0x34: return mod;
+        case 0x40: return dup;
+        case 0x41: return dup2;
+        case 0x50: return pop;
+        case 0x51: return pop2;
+        case 0x52: return show;
+        case 0x54: return showLines;
+        case 0x55: return showWords;
+        case 0x56: return readNum;
+        case 0x57: return readNums;
+        case 0x58: return showLine;
+        case 0x59: return showSpace;
+        case 0x64: return sum;
+        case 0x65: return product;
+        case 0x84: return uppercaseAlphabet;
+        case 0x85: return lowercaseAlphabet;
+        case 0x86: return asciiDigits;
+        case 0x87: return printableAscii;
+        case 0xb2: return counter;
+        default:   return nullptr;
+    }
+}
+
+const char *findCommandName(uint8_t byte) {
+    switch (byte) {
+        case 0x0a: return "new-line";
+        case 0x0b: return "empty-list";
+        case 0x0c: return "empty-block";
+        case 0x0d: return "space";
+        case 0x20: return "negate / reverse / evaluate";
+        case 0x21: return "bnot / head";
+        case 0x22: return "not / tail";
+        case 0x23: return "abs / init";
+        case 0x24: return "digits / last";
+        case 0x2a: return "double / lines";
+        case 0x2b: return "half / unlines";
+        case 0x2e: return "range / length";
+        case 0x2f: return "range1";
+        case 0x30: return "add / catenate";
+        case 0x32: return "mul / join / times / fold";
+        case 0x34: return "mod / step / clean-split / map";
+        case 0x40: return "dup";
+        case 0x41: return "dup2";
+        case 0x50: return "pop";
+        case 0x51: return "pop2";
+        case 0x52: return "show";
+        case 0x54: return "show-lines";
+        case 0x55: return "show-words";
+        case 0x56: return "read-num";
+        case 0x57: return "read-nums";
+        case 0x58: return "show-line";
+        case 0x59: return "show-space";
+        case 0x64: return "sum / even";
+        case 0x65: return "product / odd";
+        case 0x84: return "uppercase-alphabet";
+        case 0x85: return "lowercase-alphabet";
+        case 0x86: return "ascii-digits";
+        case 0x87: return "printable-ascii";
+        case 0xb2: return "counter";
+        default:   return nullptr;
+    }
+}
+
 } // namespace gs2
@@ -1,12 +1,156 @@
 #include "gs2context.hpp"
 #include "block.hpp"
+#include "command.hpp"
 #include "gs2exception.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <vector>
 
 namespace gs2 {
 
+namespace {
+
+// Maps over shorter lists aren't worth handing out to other threads
+constexpr size_t PARALLEL_MAP_THRESHOLD = 64;
+
+// Folds with a block which is just catenate or multiply, over a list where
+// that's associative, are worked out as a tree without running the block.
+// Catenate is only associative when the elements are all numbers or all
+// lists, since adding a number to a list appends or prepends it.
+std::optional<Value> treeFold(const Block &block, const List &list, size_t threads) {
+    const auto &commands = block.getCommands();
+    if (commands.size() != 1 || !commands[0].isBytes() || commands[0].getBytes().size() != 1) {
+        return std::nullopt;
+    }
+
+    auto command = commands[0].getBytes()[0];
+    if (command != 0x30 && command != 0x32) {
+        return std::nullopt;
+    }
+
+    bool numbers = list.isBytes() || list.isRange();
+    if (!numbers) {
+        numbers = std::all_of(list.begin(), list.end(), [] (const Value &value) {
+            return value.isNumber();
+        });
+    }
+
+    if (numbers) {
+        return command == 0x30 ? sumList(list, threads) : productList(list, threads);
+    }
+
+    bool lists = std::all_of(list.begin(), list.end(), [] (const Value &value) {
+        return value.isList();
+    });
+
+    if (command == 0x30 && lists) {
+        auto leaf = [&list] (size_t begin, size_t end) {
+            auto result = list[begin].getList();
+            for (auto i = begin + 1; i < end; i++) {
+                result.concat(list[i].getList());
+            }
+            return result;
+        };
+        auto op = [] (List &lhs, const List &rhs) {
+            lhs.concat(rhs);
+        };
+        return treeReduce<List>(list.size(), threads, leaf, op);
+    }
+
+    return std::nullopt;
+}
+
+class TimesLoop: public Loop {
+    private:
+        Value::IntType _count;
+
+    public:
+        TimesLoop(Block block, Value::IntType count):
+            Loop(std::move(block)),
+            _count(std::move(count))
+        {}
+
+        const char *getName() const override {
+            return "times";
+        }
+
+        bool next(GS2Context &) override {
+            if (_count <= 0) {
+                return false;
+            }
+            --_count;
+            return true;
+        }
+};
+
+class FoldLoop: public Loop {
+    private:
+        List _list;
+        size_t _index;
+
+    public:
+        FoldLoop(Block block, List list):
+            Loop(std::move(block)),
+            _list(std::move(list)),
+            _index(1)
+        {}
+
+        const char *getName() const override {
+            return "fold";
+        }
+
+        bool next(GS2Context &gs2) override {
+            if (_index >= _list.size()) {
+                return false;
+            }
+            gs2.push(_list.take(_index++));
+            return true;
+        }
+};
+
+class MapLoop: public Loop {
+    private:
+        List _list;
+        size_t _index;
+        size_t _origSize;
+
+    public:
+        MapLoop(Block block, List list, size_t origSize):
+            Loop(std::move(block)),
+            _list(std::move(list)),
+            _index(0),
+            _origSize(origSize)
+        {}
+
+        const char *getName() const override {
+            return "do_map";
+        }
+
+        bool next(GS2Context &gs2) override {
+            if (_index < _list.size()) {
+                gs2.push(_list.take(_index++));
+                return true;
+            }
+
+            gs2.push(gs2.popAbove(_origSize));
+            return false;
+        }
+};
+
+} // anonymous namespace
+
+
 GS2Context::GS2Context(List &stack):
     _stack(stack),
-    _counter(1)
+    _counter(1),
+    _engine(Engine::Threaded),
+    _threads(1),
+    _profiler(nullptr),
+    _sampler(nullptr)
 {}
 
 void GS2Context::push(Value value) {
@@ -28,24 +172,147 @@ int GS2Context::getAndIncCounter() {
     return _counter++;
 }
 
-void GS2Context::do_map(const Block &block, List list) {
-    auto origSize = _stack.size();
+Engine GS2Context::getEngine() const {
+    return _engine;
+}
+
+void GS2Context::setEngine(Engine engine) {
+    _engine = engine;
+}
+
+size_t GS2Context::getThreads() const {
+    return _threads;
+}
+
+void GS2Context::setThreads(size_t threads) {
+    _threads = threads;
+}
+
+Profiler *GS2Context::getProfiler() const {
+    return _profiler;
+}
 
-    for (auto &val: list) {
-        push(std::move(val));
+void GS2Context::setProfiler(Profiler *profiler) {
+    _profiler = profiler;
+}
+
+Sampler *GS2Context::getSampler() const {
+    return _sampler;
+}
+
+void GS2Context::setSampler(Sampler *sampler) {
+    _sampler = sampler;
+}
+
+Interpreter &GS2Context::getInterpreter() {
+    return _interpreter;
+}
+
+size_t GS2Context::getStackSize() const {
+    return _stack.size();
+}
+
+List GS2Context::popAbove(size_t stackSize) {
+    List list;
+    for (auto i = stackSize; i < _stack.size(); i++) {
+        list.add(_stack.take(i));
+    }
+
+    while (_stack.size() > stackSize) {
+        _stack.pop();
+    }
+
+    return list;
+}
+
+void GS2Context::runLoop(std::unique_ptr<Loop> loop) {
+    if (_interpreter.isRunning()) {
+        _interpreter.call(std::move(loop));
+        return;
+    }
+
+    while (true) {
+        {
+            ProfileScope scope{_profiler, loop->getName(), false};
+            if (!loop->next(*this)) {
+                break;
+            }
+        }
+        loop->getBlock().execute(*this);
+    }
+}
+
+void GS2Context::evaluate(const Block &block) {
+    ProfileScope scope{_profiler, "evaluate"};
+
+    if (_interpreter.isRunning()) {
+        _interpreter.call(block);
+    }
+    else {
         block.execute(*this);
     }
+}
+
+void GS2Context::times(const Block &block, Value::IntType count) {
+    ProfileScope scope{_profiler, "times"};
+    runLoop(std::make_unique<TimesLoop>(block, std::move(count)));
+}
 
-    list.clear();
-    for (auto i = origSize; i < _stack.size(); i++) {
-        list.add(std::move(_stack[i]));
+void GS2Context::fold(const Block &block, List list) {
+    ProfileScope scope{_profiler, "fold"};
+
+    if (list.empty()) {
+        throw GS2Exception{"Cannot fold an empty list!"};
     }
 
-    while (_stack.size() > origSize) {
-        _stack.pop();
+    if (auto result = treeFold(block, list, _threads); result) {
+        push(std::move(*result));
+        return;
     }
 
-    _stack.add(std::move(list));
+    push(list.take(0));
+    runLoop(std::make_unique<FoldLoop>(block, std::move(list)));
+}
+
+void GS2Context::parallelMap(const Block &block, List list) {
+    std::vector<Value> elements;
+    elements.reserve(list.size());
+    for (size_t i = 0; i < list.size(); i++) {
+        elements.push_back(list.take(i));
+    }
+
+    // Each element gets run on a stack of its own, and since the block can't
+    // reach below the element, whatever's left is that element's part of the
+    // result
+    std::vector<List> results(elements.size());
+    parallelFor(elements.size(), _threads, [&] (size_t i) {
+        GS2Context gs2{results[i]};
+        gs2.setEngine(_engine);
+        gs2.push(std::move(elements[i]));
+        block.execute(gs2);
+    });
+
+    List mapped;
+    for (auto &result: results) {
+        mapped.concat(result);
+    }
+    push(std::move(mapped));
+}
+
+void GS2Context::do_map(const Block &block, List list) {
+    ProfileScope scope{_profiler, "do_map"};
+
+    // The worker contexts aren't profiled or sampled, so a map which is being
+    // profiled or sampled stays on this thread to have its commands counted
+    if (_threads > 1 && !_profiler && !_sampler && list.size() >= PARALLEL_MAP_THRESHOLD &&
+        isPureBlock(block) && !containsBlock(list))
+    {
+        parallelMap(block, std::move(list));
+        return;
+    }
+
+    auto origSize = _stack.size();
+    runLoop(std::make_unique<MapLoop>(block, std::move(list), origSize));
 }
 
 } // namespace gs2
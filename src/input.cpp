@@ -0,0 +1,192 @@
+#include "input.hpp"
+#include "search.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <memory>
+
+#ifdef WIN32
+    #include <io.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace gs2 {
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 1 << 16;
+
+// Reads some data, returning how much was read, 0 at the end of the file or
+// -1 on error
+long readSome(int fd, uint8_t *data, size_t size) {
+#ifdef WIN32
+    return _read(fd, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+    return ::read(fd, data, size);
+#endif
+}
+
+// How much is left to read of a regular file, or 0 for anything else
+size_t remainingSize(int fd) {
+#ifdef WIN32
+    (void) fd;
+    return 0;
+#else
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return 0;
+    }
+
+    auto offset = lseek(fd, 0, SEEK_CUR);
+    return offset >= 0 && offset < info.st_size ? info.st_size - offset : 0;
+#endif
+}
+
+#ifndef WIN32
+// Maps what's left of a regular file into memory, and moves the file to its
+// end, the same as reading it would. Gives back an empty list if the file
+// can't be mapped, or if there's nothing left of it.
+List readMapped(int fd) {
+    auto remaining = remainingSize(fd);
+    if (remaining == 0) {
+        return {};
+    }
+
+    // Mappings have to start on a page boundary, so the whole file is mapped
+    // and the part which was already read is skipped
+    size_t offset = lseek(fd, 0, SEEK_CUR);
+    size_t size = offset + remaining;
+    auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return {};
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    lseek(fd, 0, SEEK_END);
+
+    std::shared_ptr<const void> owner{mapping, [size] (const void *start) {
+        munmap(const_cast<void *>(start), size);
+    }};
+    auto data = static_cast<const uint8_t *>(mapping);
+    return List{List::Mapped{std::move(owner), {data + offset, size - offset}}};
+}
+#endif
+
+} // anonymous namespace
+
+List readInput(int fd) {
+#ifndef WIN32
+    if (auto mapped = readMapped(fd); !mapped.empty()) {
+        return mapped;
+    }
+#endif
+
+    // A regular file which couldn't be mapped fits exactly
+    List::Bytes bytes(remainingSize(fd));
+    size_t used = 0;
+
+    while (true) {
+        if (used == bytes.size()) {
+            // Only grow once there's more to read, so that input which fills
+            // the buffer exactly doesn't leave room to spare
+            uint8_t next;
+            auto read = readSome(fd, &next, 1);
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            else if (read <= 0) {
+                break;
+            }
+            bytes.resize(std::max(bytes.size() * 2, used + CHUNK_SIZE));
+            bytes[used++] = next;
+        }
+
+        auto read = readSome(fd, bytes.data() + used, bytes.size() - used);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        else if (read <= 0) {
+            break;
+        }
+        used += read;
+    }
+
+    bytes.resize(used);
+    bytes.shrink_to_fit();
+    return List{std::move(bytes)};
+}
+
+LineReader::LineReader(int fd):
+    _fd(fd),
+    _buffer(CHUNK_SIZE),
+    _start(0),
+    _end(0),
+    _finished(false),
+    _linesRead(0)
+{}
+
+size_t LineReader::fill() {
+    auto moved = _start;
+    std::copy(_buffer.begin() + _start, _buffer.begin() + _end, _buffer.begin());
+    _end -= _start;
+    _start = 0;
+
+    if (_end == _buffer.size()) {
+        _buffer.resize(_buffer.size() * 2);
+    }
+
+    while (true) {
+        auto read = readSome(_fd, _buffer.data() + _end, _buffer.size() - _end);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        else if (read <= 0) {
+            _finished = true;
+        }
+        else {
+            _end += read;
+        }
+        return moved;
+    }
+}
+
+bool LineReader::next(List::Bytes &line) {
+    // Where to start looking for the newline, so nothing is searched twice
+    auto scanned = _start;
+
+    while (true) {
+        const uint8_t *data = _buffer.data();
+        auto newline = findByte(data + scanned, data + _end, '\n');
+
+        if (newline != data + _end) {
+            line.assign(data + _start, newline);
+            _start = newline - data + 1;
+            _linesRead++;
+            return true;
+        }
+        else if (_finished) {
+            // The last line doesn't need to end with a newline
+            if (_start == _end && _linesRead > 0) {
+                return false;
+            }
+
+            line.assign(data + _start, data + _end);
+            _start = _end;
+            _linesRead++;
+            return true;
+        }
+
+        scanned = _end;
+        scanned -= fill();
+    }
+}
+
+bool LineReader::hasBufferedLine() const {
+    auto data = _buffer.data();
+    return _finished || findByte(data + _start, data + _end, '\n') != data + _end;
+}
+
+} // namespace gs2
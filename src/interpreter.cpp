@@ -0,0 +1,382 @@
+#include "interpreter.hpp"
+#include "gs2context.hpp"
+#include "gs2exception.hpp"
+#include "profiler.hpp"
+#include "program.hpp"
+#include "sampler.hpp"
+
+#include <iterator>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(GS2_NO_COMPUTED_GOTO)
+    #define GS2_COMPUTED_GOTO 1
+#else
+    #define GS2_COMPUTED_GOTO 0
+#endif
+
+namespace gs2 {
+
+namespace {
+
+inline void pushNumber(GS2Context &gs2, const Instruction *insn) {
+    gs2.push(insn->immediate);
+}
+
+inline void pushConstants(const Program &program, GS2Context &gs2, const Instruction *insn) {
+    for (size_t i = 0; i < static_cast<size_t>(insn->immediate); i++) {
+        gs2.push(program.getConstant(insn->operand + i));
+    }
+}
+
+inline void pushBlock(const Program &program, GS2Context &gs2, const Instruction *insn) {
+    gs2.push(Block{program.shared_from_this(), insn->operand});
+}
+
+[[noreturn]] void badCommand(const Instruction *insn) {
+    throw GS2Exception{"Unhandled command byte: " + std::to_string(insn->byte)};
+}
+
+[[noreturn]] void badStringEnd(const Instruction *insn) {
+    throw GS2Exception{"Unhandled string end byte: " + std::to_string(insn->byte)};
+}
+
+#if !GS2_COMPUTED_GOTO
+
+// Without computed gotos, the threaded engine falls back to a table of
+// handlers, each of which returns the next instruction to run
+using Handler = const Instruction *(*)(const Program &, GS2Context &, const Instruction *);
+
+const Instruction *handlePushNumber(const Program &, GS2Context &gs2, const Instruction *insn) {
+    pushNumber(gs2, insn);
+    return insn + 1;
+}
+
+const Instruction *handlePushConstants(const Program &program, GS2Context &gs2, const Instruction *insn) {
+    pushConstants(program, gs2, insn);
+    return insn + 1;
+}
+
+const Instruction *handlePushBlock(const Program &program, GS2Context &gs2, const Instruction *insn) {
+    pushBlock(program, gs2, insn);
+    return insn + 1;
+}
+
+const Instruction *handleCall(const Program &, GS2Context &gs2, const Instruction *insn) {
+    insn->command(gs2);
+    return insn + 1;
+}
+
+const Instruction *handleBadCommand(const Program &, GS2Context &, const Instruction *insn) {
+    badCommand(insn);
+}
+
+const Instruction *handleBadStringEnd(const Program &, GS2Context &, const Instruction *insn) {
+    badStringEnd(insn);
+}
+
+const Instruction *handleReturn(const Program &, GS2Context &, const Instruction *) {
+    return nullptr;
+}
+
+constexpr Handler HANDLERS[] = {
+    handlePushNumber,
+    handlePushConstants,
+    handlePushBlock,
+    handleCall,
+    handleBadCommand,
+    handleBadStringEnd,
+    handleReturn,
+};
+
+static_assert(std::size(HANDLERS) == static_cast<size_t>(Op::Return) + 1,
+              "Every op needs a handler");
+
+#endif
+
+} // anonymous namespace
+
+Loop::Loop(Block block): _block(std::move(block)) {}
+
+Loop::~Loop() {}
+
+const Block &Loop::getBlock() const {
+    return _block;
+}
+
+void Interpreter::run(GS2Context &gs2, const Block &block) {
+    auto base = _frames.size();
+
+    // If a command throws, its caller's frames are abandoned
+    struct Unwind {
+        std::vector<Frame> &frames;
+        size_t base;
+
+        ~Unwind() {
+            while (frames.size() > base) {
+                frames.pop_back();
+            }
+        }
+    } unwind{_frames, base};
+
+    call(block);
+
+    while (_frames.size() > base) {
+        auto index = _frames.size() - 1;
+        auto &frame = _frames[index];
+
+        if (frame.loop) {
+            // The loop lives on the heap, so its block stays put even when
+            // calling it grows the frame stack
+            auto loop = frame.loop.get();
+            bool more;
+            {
+                ProfileScope scope{gs2.getProfiler(), loop->getName(), false};
+                more = loop->next(gs2);
+            }
+            if (gs2.getSampler() && Sampler::isDue()) {
+                sample(gs2, index, {0, 0, loop->getName()});
+            }
+            if (more) {
+                call(loop->getBlock());
+            }
+            else {
+                _frames.pop_back();
+            }
+        }
+        else if (!frame.program) {
+            auto piece = std::move(frame.block);
+            _frames.pop_back();
+            call(piece);
+        }
+        else {
+            auto returned = gs2.getSampler() ? runSampled(*this, gs2, index)
+                : gs2.getProfiler() ? runProfiled(*this, gs2, index)
+                : gs2.getEngine() == Engine::Switch ? runSwitch(*this, gs2, index)
+                : runThreaded(*this, gs2, index);
+
+            if (returned) {
+                _frames.pop_back();
+            }
+        }
+    }
+}
+
+bool Interpreter::isRunning() const {
+    return !_frames.empty();
+}
+
+void Interpreter::call(const Block &block) {
+    // Only the first piece of a concatenation is needed right away, the rest
+    // get their own frames and are expanded once they're reached
+    auto piece = &block;
+    while (piece->isConcatenation()) {
+        _frames.push_back({nullptr, nullptr, piece->getSecond(), nullptr});
+        piece = &piece->getFirst();
+    }
+
+    auto &program = piece->getProgram();
+    auto insn = &program.getCode()[program.getBlockStart(piece->getProgramIndex())];
+    _frames.push_back({&program, insn, *piece, nullptr});
+}
+
+void Interpreter::call(std::unique_ptr<Loop> loop) {
+    _frames.push_back({nullptr, nullptr, Block{}, std::move(loop)});
+}
+
+void Interpreter::sample(GS2Context &gs2, size_t frameIndex, const SampleFrame &top) {
+    std::vector<SampleFrame> path;
+
+    for (size_t i = 0; i < frameIndex; i++) {
+        const auto &frame = _frames[i];
+
+        // A frame which is running code has already moved on past the
+        // command which called the frame above it, while the pieces of a
+        // concatenation which haven't been reached aren't running at all
+        if (frame.loop) {
+            path.push_back({0, 0, frame.loop->getName()});
+        }
+        else if (frame.program) {
+            auto caller = frame.insn - 1;
+            path.push_back({caller->byte, caller->offset, nullptr});
+        }
+    }
+
+    path.push_back(top);
+    gs2.getSampler()->record(path);
+}
+
+bool runSwitch(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex) {
+    auto &frames = interpreter._frames;
+    auto &program = *frames[frameIndex].program;
+    auto insn = frames[frameIndex].insn;
+
+    for (;; ++insn) {
+        switch (insn->op) {
+            case Op::PushNumber:      pushNumber(gs2, insn);                break;
+            case Op::PushConstants:   pushConstants(program, gs2, insn);    break;
+            case Op::PushBlock:       pushBlock(program, gs2, insn);        break;
+            case Op::BadCommand:      badCommand(insn);
+            case Op::BadStringEnd:    badStringEnd(insn);
+            case Op::Return:          return true;
+
+            case Op::Call:
+                insn->command(gs2);
+                if (frames.size() != frameIndex + 1) {
+                    frames[frameIndex].insn = insn + 1;
+                    return false;
+                }
+                break;
+        }
+    }
+}
+
+bool runProfiled(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex) {
+    using Clock = Profiler::Clock;
+
+    auto &frames = interpreter._frames;
+    auto &program = *frames[frameIndex].program;
+    auto &profiler = *gs2.getProfiler();
+    auto insn = frames[frameIndex].insn;
+
+    for (;; ++insn) {
+        auto start = Clock::now();
+
+        switch (insn->op) {
+            case Op::PushNumber:      pushNumber(gs2, insn);                break;
+            case Op::PushConstants:   pushConstants(program, gs2, insn);    break;
+            case Op::PushBlock:       pushBlock(program, gs2, insn);        break;
+            case Op::BadCommand:      badCommand(insn);
+            case Op::BadStringEnd:    badStringEnd(insn);
+            case Op::Return:          return true;
+
+            case Op::Call:
+                insn->command(gs2);
+                if (frames.size() != frameIndex + 1) {
+                    profiler.addCommand(insn->byte, Clock::now() - start);
+                    frames[frameIndex].insn = insn + 1;
+                    return false;
+                }
+                break;
+        }
+
+        profiler.addCommand(insn->byte, Clock::now() - start);
+    }
+}
+
+bool runSampled(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex) {
+    auto &frames = interpreter._frames;
+    auto &program = *frames[frameIndex].program;
+    auto insn = frames[frameIndex].insn;
+
+    for (;; ++insn) {
+        switch (insn->op) {
+            case Op::PushNumber:      pushNumber(gs2, insn);                break;
+            case Op::PushConstants:   pushConstants(program, gs2, insn);    break;
+            case Op::PushBlock:       pushBlock(program, gs2, insn);        break;
+            case Op::BadCommand:      badCommand(insn);
+            case Op::BadStringEnd:    badStringEnd(insn);
+            case Op::Return:          return true;
+
+            case Op::Call:
+                insn->command(gs2);
+                if (Sampler::isDue()) {
+                    interpreter.sample(gs2, frameIndex, {insn->byte, insn->offset, nullptr});
+                }
+                if (frames.size() != frameIndex + 1) {
+                    frames[frameIndex].insn = insn + 1;
+                    return false;
+                }
+                continue;
+        }
+
+        if (Sampler::isDue()) {
+            interpreter.sample(gs2, frameIndex, {insn->byte, insn->offset, nullptr});
+        }
+    }
+}
+
+#if GS2_COMPUTED_GOTO
+
+// Labels as values are a GNU extension, which -Wpedantic complains about
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+bool runThreaded(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex) {
+    static const void *const labels[] = {
+        &&push_number,
+        &&push_constants,
+        &&push_block,
+        &&call,
+        &&bad_command,
+        &&bad_string_end,
+        &&return_op,
+    };
+
+    static_assert(std::size(labels) == static_cast<size_t>(Op::Return) + 1,
+                  "Every op needs a label");
+
+    auto &frames = interpreter._frames;
+    auto &program = *frames[frameIndex].program;
+    auto insn = frames[frameIndex].insn;
+
+    #define DISPATCH() goto *labels[static_cast<size_t>(insn->op)]
+    #define NEXT() do { ++insn; DISPATCH(); } while (false)
+
+    DISPATCH();
+
+push_number:
+    pushNumber(gs2, insn);
+    NEXT();
+
+push_constants:
+    pushConstants(program, gs2, insn);
+    NEXT();
+
+push_block:
+    pushBlock(program, gs2, insn);
+    NEXT();
+
+call:
+    insn->command(gs2);
+    if (frames.size() != frameIndex + 1) {
+        frames[frameIndex].insn = insn + 1;
+        return false;
+    }
+    NEXT();
+
+bad_command:
+    badCommand(insn);
+
+bad_string_end:
+    badStringEnd(insn);
+
+return_op:
+    return true;
+
+    #undef NEXT
+    #undef DISPATCH
+}
+
+#pragma GCC diagnostic pop
+
+#else
+
+bool runThreaded(Interpreter &interpreter, GS2Context &gs2, size_t frameIndex) {
+    auto &frames = interpreter._frames;
+    auto &program = *frames[frameIndex].program;
+    auto insn = frames[frameIndex].insn;
+
+    while (insn) {
+        insn = HANDLERS[static_cast<size_t>(insn->op)](program, gs2, insn);
+        if (insn && frames.size() != frameIndex + 1) {
+            frames[frameIndex].insn = insn;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
+
+} // namespace gs2
@@ -0,0 +1,43 @@
+#include "linemode.hpp"
+#include "block.hpp"
+#include "input.hpp"
+#include "output.hpp"
+
+namespace gs2 {
+
+void streamLines(const Block &block, LineReader &reader, Output &output, Engine engine,
+                 Profiler *profiler, Sampler *sampler)
+{
+    List stack;
+    GS2Context gs2{stack};
+    gs2.setEngine(engine);
+    gs2.setProfiler(profiler);
+    gs2.setSampler(sampler);
+
+    List::Bytes line;
+    bool first = true;
+
+    while (true) {
+        if (!reader.hasBufferedLine()) {
+            output.flush();
+        }
+        if (!reader.next(line)) {
+            break;
+        }
+
+        stack.clear();
+        stack.add(List{std::move(line)});
+        block.execute(gs2);
+
+        // The results are joined with newlines, just like show-lines does
+        for (const auto &value: stack) {
+            if (!first) {
+                output.put('\n');
+            }
+            output.write(value);
+            first = false;
+        }
+    }
+}
+
+} // namespace gs2
@@ -1,22 +1,293 @@
 #include "list.hpp"
 #include "gs2exception.hpp"
+#include "shared.hpp"
 #include "value.hpp"
 
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <type_traits>
+#include <variant>
 
 namespace gs2 {
 
+namespace {
+
+// Lists at least this long are switched to ropes instead of having their
+// elements copied to prepend to them or concatenate them onto another list
+constexpr size_t ROPE_THRESHOLD = 64;
+
+// Byte strings are much cheaper to copy, and lose their fast paths for
+// splitting, searching and writing once they're in a rope, so they're kept
+// flat for longer
+constexpr size_t BYTE_ROPE_THRESHOLD = 16 * 1024;
+
+size_t ropeThreshold(const List &list) {
+    return list.isBytes() ? BYTE_ROPE_THRESHOLD : ROPE_THRESHOLD;
+}
+
+} // anonymous namespace
+
+List::const_iterator::const_iterator(const List *list, size_t index):
+    _list(list),
+    _index(index)
+{}
+
+List::const_iterator::reference List::const_iterator::operator*() const {
+    return (*_list)[_index];
+}
+
+List::const_iterator::pointer List::const_iterator::operator->() const {
+    return &(*_list)[_index];
+}
+
+List::const_iterator::reference List::const_iterator::operator[](difference_type offset) const {
+    return (*_list)[_index + offset];
+}
+
+List::const_iterator &List::const_iterator::operator++() {
+    ++_index;
+    return *this;
+}
+
+List::const_iterator &List::const_iterator::operator--() {
+    --_index;
+    return *this;
+}
+
+List::const_iterator List::const_iterator::operator++(int) {
+    auto old = *this;
+    ++_index;
+    return old;
+}
+
+List::const_iterator List::const_iterator::operator--(int) {
+    auto old = *this;
+    --_index;
+    return old;
+}
+
+List::const_iterator &List::const_iterator::operator+=(difference_type offset) {
+    _index += offset;
+    return *this;
+}
+
+List::const_iterator &List::const_iterator::operator-=(difference_type offset) {
+    _index -= offset;
+    return *this;
+}
+
+List::const_iterator List::const_iterator::operator+(difference_type offset) const {
+    return {_list, _index + offset};
+}
+
+List::const_iterator List::const_iterator::operator-(difference_type offset) const {
+    return {_list, _index - offset};
+}
+
+List::const_iterator::difference_type List::const_iterator::operator-(const const_iterator &rhs) const {
+    return static_cast<difference_type>(_index) - static_cast<difference_type>(rhs._index);
+}
+
+bool List::const_iterator::operator==(const const_iterator &rhs) const {
+    return _index == rhs._index;
+}
+
+bool List::const_iterator::operator!=(const const_iterator &rhs) const {
+    return _index != rhs._index;
+}
+
+bool List::const_iterator::operator<(const const_iterator &rhs) const {
+    return _index < rhs._index;
+}
+
+struct List::Storage {
+    std::variant<Bytes, std::pmr::vector<Value>, Range, Rope, Mapped> elements;
+
+    // A range's elements, all filled in the first time one is read in place,
+    // since operator[] returns a reference. They're only dropped along with
+    // the storage, which pop and reverse replace rather than modify.
+    std::once_flag rangeFilled;
+    std::pmr::vector<Value> rangeValues;
+
+    Storage() = default;
+
+    template <typename T>
+    explicit Storage(T elements): elements(std::move(elements)) {}
+
+    Storage(const Storage &storage): elements(storage.elements) {}
+};
+
+template <typename... Args>
+std::shared_ptr<List::Storage> List::makeStorage(Args&&... args) {
+    return std::allocate_shared<Storage>(
+        std::pmr::polymorphic_allocator<Storage>{},
+        std::forward<Args>(args)...
+    );
+}
+
+int64_t List::Range::at(size_t index) const {
+    return start + static_cast<int64_t>(index) * step;
+}
+
+List::ByteView::ByteView(const uint8_t *data, size_t size): _data(data), _size(size) {}
+
+List::ByteView::ByteView(const Bytes &bytes): _data(bytes.data()), _size(bytes.size()) {}
+
+bool List::ByteView::operator==(const ByteView &rhs) const {
+    return std::equal(begin(), end(), rhs.begin(), rhs.end());
+}
+
+bool List::ByteView::operator!=(const ByteView &rhs) const {
+    return !(*this == rhs);
+}
+
+const uint8_t *List::ByteView::data() const {
+    return _data;
+}
+
+size_t List::ByteView::size() const {
+    return _size;
+}
+
+bool List::ByteView::empty() const {
+    return _size == 0;
+}
+
+uint8_t List::ByteView::operator[](size_t index) const {
+    return _data[index];
+}
+
+const uint8_t *List::ByteView::begin() const {
+    return _data;
+}
+
+const uint8_t *List::ByteView::end() const {
+    return _data + _size;
+}
+
 List::List() {}
 
+List::List(Bytes bytes): _storage(makeStorage(std::move(bytes))) {}
+
+List::List(Range range) {
+    if (range.count > 0) {
+        _storage = makeStorage(range);
+    }
+}
+
+List::List(Mapped mapped) {
+    if (!mapped.bytes.empty()) {
+        _storage = makeStorage(std::move(mapped));
+    }
+}
+
 List::~List() {}
 
+const std::pmr::vector<Value> &List::values() const {
+    return std::get<std::pmr::vector<Value>>(_storage->elements);
+}
+
+List::Storage &List::mutate() {
+    if (!_storage) {
+        _storage = makeStorage();
+    }
+    else if (!isUnique(_storage)) {
+        _storage = makeStorage(*_storage);
+    }
+
+    if (auto mapped = std::get_if<Mapped>(&_storage->elements)) {
+        _storage->elements = Bytes(mapped->bytes.begin(), mapped->bytes.end());
+    }
+    return *_storage;
+}
+
+List::Storage &List::expand() {
+    auto &storage = mutate();
+
+    if (auto range = std::get_if<Range>(&storage.elements)) {
+        auto first = range->at(0);
+        auto last = range->at(range->count - 1);
+
+        if (std::min(first, last) >= 0 && std::max(first, last) <= 0xff) {
+            Bytes bytes;
+            bytes.reserve(range->count);
+            for (size_t i = 0; i < range->count; i++) {
+                bytes.push_back(static_cast<uint8_t>(range->at(i)));
+            }
+            storage.elements = std::move(bytes);
+        }
+        else {
+            std::pmr::vector<Value> values;
+            values.reserve(range->count);
+            for (size_t i = 0; i < range->count; i++) {
+                values.emplace_back(range->at(i));
+            }
+            storage.elements = std::move(values);
+        }
+    }
+
+    return storage;
+}
+
+std::pmr::vector<Value> &List::promote() {
+    auto &elements = expand().elements;
+
+    if (auto bytes = std::get_if<Bytes>(&elements)) {
+        std::pmr::vector<Value> values;
+        values.reserve(bytes->size());
+        for (auto byte: *bytes) {
+            values.emplace_back(byteValue(byte));
+        }
+        elements = std::move(values);
+    }
+    else if (auto rope = std::get_if<Rope>(&elements)) {
+        elements = rope->values();
+    }
+
+    return std::get<std::pmr::vector<Value>>(elements);
+}
+
+Rope &List::makeRope() {
+    if (auto rope = std::get_if<Rope>(&mutate().elements)) {
+        return *rope;
+    }
+
+    // Byte strings keep their bytes in the rope instead of becoming Values
+    auto &elements = expand().elements;
+    if (auto bytes = std::get_if<Bytes>(&elements)) {
+        elements = Rope{*bytes};
+    }
+    else {
+        elements = Rope{std::move(std::get<std::pmr::vector<Value>>(elements))};
+    }
+    return std::get<Rope>(elements);
+}
+
 bool List::operator!=(const List &rhs) const {
-    if (_values.size() != rhs.size()) {
+    if (_storage == rhs._storage) {
+        return false;
+    }
+
+    if (isBytes() && rhs.isBytes()) {
+        return getBytes() != rhs.getBytes();
+    }
+
+    if (size() != rhs.size()) {
         return true;
     }
 
+    if (isRange() && rhs.isRange()) {
+        const auto &range = getRange();
+        const auto &rhsRange = rhs.getRange();
+        return range.start != rhsRange.start ||
+               (range.count > 1 && range.step != rhsRange.step);
+    }
+
     for (size_t i = 0; i < rhs.size(); i++) {
-        if (_values[i] != rhs[i]) {
+        if ((*this)[i] != rhs[i]) {
             return true;
         }
     }
@@ -25,73 +296,280 @@ bool List::operator!=(const List &rhs) const {
 }
 
 void List::add(Value value) {
-    _values.emplace_back(std::move(value));
+    auto &elements = expand().elements;
+
+    if (auto values = std::get_if<std::pmr::vector<Value>>(&elements)) {
+        values->emplace_back(std::move(value));
+    }
+    else if (auto rope = std::get_if<Rope>(&elements)) {
+        rope->append(std::move(value));
+    }
+    else if (isByte(value)) {
+        std::get<Bytes>(elements).push_back(static_cast<uint8_t>(value.getNumber()));
+    }
+    else {
+        promote().emplace_back(std::move(value));
+    }
 }
 
 void List::concat(const List &list) {
-    _values.insert(_values.end(), list._values.begin(), list._values.end());
+    if (list.empty()) {
+        return;
+    }
+
+    if (empty()) {
+        _storage = list._storage;
+        return;
+    }
+
+    if (isRope() || list.isRope() || list.size() >= ropeThreshold(list)) {
+        // Copy the other list first, in case it's this one
+        auto other = list;
+        makeRope().concat(other.makeRope());
+        return;
+    }
+
+    if (isBytes() && list.isBytes()) {
+        // Copy the other list first, in case it shares our storage
+        auto other = list;
+        auto otherBytes = other.getBytes();
+        auto &bytes = std::get<Bytes>(mutate().elements);
+        bytes.insert(bytes.end(), otherBytes.begin(), otherBytes.end());
+        return;
+    }
+
+    auto other = list;
+    auto &values = promote();
+    values.reserve(values.size() + other.size());
+    for (size_t i = 0; i < other.size(); i++) {
+        values.push_back(other.take(i));
+    }
 }
 
-void List::insert(std::vector<Value>::iterator it, Value value) {
-    _values.insert(it, std::move(value));
+void List::prepend(Value value) {
+    if (size() >= ropeThreshold(*this)) {
+        makeRope().prepend(std::move(value));
+        return;
+    }
+
+    auto &elements = expand().elements;
+
+    if (auto bytes = std::get_if<Bytes>(&elements)) {
+        if (isByte(value)) {
+            bytes->insert(bytes->begin(), static_cast<uint8_t>(value.getNumber()));
+            return;
+        }
+    }
+
+    auto &values = promote();
+    values.insert(values.begin(), std::move(value));
 }
 
 Value List::pop() {
-    if (_values.empty()) {
+    if (!_storage) {
         throw GS2Exception{"Cannot pop an empty list!"};
     }
 
-    auto value = std::move(_values.back());
-    _values.pop_back();
-    return value;
+    // Ranges are replaced rather than modified, since their elements might
+    // have been filled in already
+    if (isRange()) {
+        auto range = getRange();
+        range.count--;
+        _storage = range.count > 0 ? makeStorage(range) : nullptr;
+        return range.at(range.count);
+    }
+
+    if (isRope()) {
+        return splitAt(size() - 1)[0];
+    }
+
+    // Mapped bytes are only read, so popping one just leaves a shorter view
+    if (auto mapped = std::get_if<Mapped>(&_storage->elements)) {
+        auto bytes = mapped->bytes;
+        auto rest = Mapped{mapped->owner, ByteView{bytes.data(), bytes.size() - 1}};
+        _storage = rest.bytes.empty() ? nullptr : makeStorage(std::move(rest));
+        return byteValue(bytes[bytes.size() - 1]);
+    }
+
+    auto &elements = mutate().elements;
+
+    if (auto values = std::get_if<std::pmr::vector<Value>>(&elements); values && !values->empty()) {
+        auto value = std::move(values->back());
+        values->pop_back();
+        return value;
+    }
+    else if (auto bytes = std::get_if<Bytes>(&elements); bytes && !bytes->empty()) {
+        auto byte = bytes->back();
+        bytes->pop_back();
+        return byteValue(byte);
+    }
+
+    throw GS2Exception{"Cannot pop an empty list!"};
 }
 
 void List::clear() {
-    _values.clear();
+    _storage.reset();
 }
 
 void List::reverse() {
-    std::reverse(_values.begin(), _values.end());
-}
+    if (empty()) {
+        return;
+    }
 
-std::vector<Value>::iterator List::begin() {
-    return _values.begin();
-}
+    if (isRange() && getRange().step != std::numeric_limits<int64_t>::min()) {
+        const auto &range = getRange();
+        _storage = makeStorage(Range{range.at(range.count - 1), -range.step, range.count});
+        return;
+    }
+
+    if (isRope()) {
+        promote();
+    }
 
-std::vector<Value>::iterator List::end() {
-    return _values.end();
+    std::visit([] (auto &elements) {
+        using T = std::decay_t<decltype(elements)>;
+
+        if constexpr (std::is_same_v<T, Bytes> || std::is_same_v<T, std::pmr::vector<Value>>) {
+            std::reverse(elements.begin(), elements.end());
+        }
+    }, expand().elements);
 }
 
-std::vector<Value>::const_iterator List::begin() const {
-    return _values.begin();
+Value List::take(size_t index) {
+    if (isRange()) {
+        return getRange().at(index);
+    }
+
+    // Elements shared with another list have to stay where they are
+    if (isBytes() || isRope() || !isUnique(_storage)) {
+        return (*this)[index];
+    }
+    return std::move(std::get<std::pmr::vector<Value>>(_storage->elements)[index]);
 }
 
-std::vector<Value>::const_iterator List::end() const {
-    return _values.end();
+List List::splitAt(size_t index) {
+    if (index >= size()) {
+        return {};
+    }
+
+    if (isRange()) {
+        auto range = getRange();
+        _storage = index > 0 ? makeStorage(Range{range.start, range.step, index}) : nullptr;
+        return List{Range{range.at(index), range.step, range.count - index}};
+    }
+
+    // Both halves of mapped bytes keep reading the same mapping
+    if (auto mapped = std::get_if<Mapped>(&_storage->elements)) {
+        auto owner = mapped->owner;
+        auto bytes = mapped->bytes;
+        _storage = index > 0 ? makeStorage(Mapped{owner, ByteView{bytes.data(), index}}) : nullptr;
+        return List{Mapped{owner, ByteView{bytes.data() + index, bytes.size() - index}}};
+    }
+
+    List rest;
+    auto &elements = mutate().elements;
+
+    if (auto rope = std::get_if<Rope>(&elements)) {
+        rest._storage = makeStorage(rope->splitAt(index));
+    }
+    else if (auto bytes = std::get_if<Bytes>(&elements)) {
+        rest = List{Bytes(bytes->begin() + index, bytes->end())};
+        bytes->erase(bytes->begin() + index, bytes->end());
+    }
+    else {
+        auto &values = std::get<std::pmr::vector<Value>>(elements);
+        rest._storage = makeStorage(std::pmr::vector<Value>(
+            std::make_move_iterator(values.begin() + index),
+            std::make_move_iterator(values.end())
+        ));
+        values.erase(values.begin() + index, values.end());
+    }
+
+    return rest;
 }
 
-Value& List::operator[](size_t index) {
-    return _values[index];
+List::const_iterator List::begin() const {
+    return {this, 0};
 }
 
-const Value& List::operator[](size_t index) const {
-    return _values[index];
+List::const_iterator List::end() const {
+    return {this, size()};
 }
 
-Value& List::back() {
-    return _values.back();
+const Value& List::operator[](size_t index) const {
+    if (isBytes()) {
+        return byteValue(getBytes()[index]);
+    }
+    else if (isRange()) {
+        auto &storage = *_storage;
+        std::call_once(storage.rangeFilled, [&storage] {
+            const auto &range = std::get<Range>(storage.elements);
+            storage.rangeValues.reserve(range.count);
+            for (size_t i = 0; i < range.count; i++) {
+                storage.rangeValues.emplace_back(range.at(i));
+            }
+        });
+        return storage.rangeValues[index];
+    }
+    else if (isRope()) {
+        return std::get<Rope>(_storage->elements)[index];
+    }
+    return values()[index];
 }
 
 const Value& List::back() const {
-    return _values.back();
+    return (*this)[size() - 1];
 }
 
 size_t List::size() const {
-    return _values.size();
+    if (!_storage) {
+        return 0;
+    }
+
+    return std::visit([] (const auto &elements) -> size_t {
+        using T = std::decay_t<decltype(elements)>;
+
+        if constexpr (std::is_same_v<T, Range>) {
+            return elements.count;
+        }
+        else if constexpr (std::is_same_v<T, Mapped>) {
+            return elements.bytes.size();
+        }
+        else {
+            return elements.size();
+        }
+    }, _storage->elements);
 }
 
 bool List::empty() const {
-    return _values.empty();
+    return size() == 0;
+}
+
+bool List::isBytes() const {
+    return !_storage || std::holds_alternative<Bytes>(_storage->elements) ||
+           std::holds_alternative<Mapped>(_storage->elements);
+}
+
+List::ByteView List::getBytes() const {
+    if (!_storage) {
+        return {nullptr, 0};
+    }
+    else if (auto mapped = std::get_if<Mapped>(&_storage->elements)) {
+        return mapped->bytes;
+    }
+    return std::get<Bytes>(_storage->elements);
+}
+
+bool List::isRange() const {
+    return _storage && std::holds_alternative<Range>(_storage->elements);
+}
+
+const List::Range &List::getRange() const {
+    return std::get<Range>(_storage->elements);
+}
+
+bool List::isRope() const {
+    return _storage && std::holds_alternative<Rope>(_storage->elements);
 }
 
 } // namespace gs2
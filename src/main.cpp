@@ -1,11 +1,23 @@
+#include "arena.hpp"
 #include "block.hpp"
 #include "gs2context.hpp"
 #include "gs2exception.hpp"
+#include "input.hpp"
+#include "linemode.hpp"
+#include "output.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "program.hpp"
+#include "sampler.hpp"
 
 #include <CLI/CLI.hpp>
 
+#include <chrono>
+#include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <vector>
 
 #ifdef WIN32
     #include <io.h>
@@ -14,28 +26,85 @@
     #include <unistd.h>
 #endif
 
-gs2::List initialStack() {
+int openInput(const std::string &name) {
+#ifdef WIN32
+    return _open(name.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return open(name.c_str(), O_RDONLY);
+#endif
+}
+
+void closeInput(int fd) {
+#ifdef WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+gs2::List initialStack(int inputFd) {
     gs2::List input;
 
-    if (!isatty(STDIN_FILENO)) {
-        char c;
-        while (std::cin.get(c)) {
-            input.add(c);
-        }
+    if (!isatty(inputFd)) {
+        input = gs2::readInput(inputFd);
     }
 
     gs2::List stack;
-    stack.add(input);
+    stack.add(std::move(input));
     return stack;
 }
 
+gs2::Engine getEngine(const std::string &name) {
+    if (name == "tree") {
+        return gs2::Engine::TreeWalker;
+    }
+    else if (name == "switch") {
+        return gs2::Engine::Switch;
+    }
+    else {
+        return gs2::Engine::Threaded;
+    }
+}
+
 int main(int argc, char **argv) {
     std::string filename;
-    bool printVersion;
+    std::string inputFilename;
+    std::string engine = "threaded";
+    int optimizationLevel = 1;
+    size_t threads = 0;
+    bool printVersion = false;
+    bool reportOptimizations = false;
+    bool useArena = false;
+    bool streamLines = false;
+    bool profile = false;
+    std::string sampleFilename;
+    int sampleInterval = 1000;
 
     CLI::App app{"An interpreter for the gs2 programming language."};
     app.add_option("file", filename, "The gs2 file to interpret.");
+    app.add_option("--input", inputFilename, "Read the program's input from a file instead of stdin.");
     app.add_flag("-v,--version", printVersion, "Print the gs2 version and exit.");
+    app.add_option("--engine", engine, "The engine used to execute the program.")
+       ->check(CLI::IsMember({"tree", "switch", "threaded"}));
+    app.add_option("-O,--optimize", optimizationLevel, "The optimization level, from 0 to 2.")
+       ->check(CLI::Range(0, 2));
+    app.add_option("-j,--threads", threads,
+                   "How many threads map can use for pure blocks, or 0 for one per core.");
+    app.add_flag("--report-optimizations", reportOptimizations,
+                 "Print how many times each optimization was applied to stderr.");
+    app.add_flag("--arena", useArena,
+                 "Allocate lists and blocks from a memory pool instead of the heap.");
+    app.add_flag("--stream-lines", streamLines,
+                 "Run line mode programs on each line as it's read, writing out its results right away.");
+    auto profileFlag = app.add_flag("--profile", profile,
+                                    "Print how many times each command ran and how long it took to stderr.");
+    app.add_option("--sample", sampleFilename,
+                   "Sample where the program is as it runs, writing the samples to a file in the folded "
+                   "stack format for flame graphs, and printing the hottest source offsets to stderr. "
+                   "Maps run on one thread while sampling.")
+       ->excludes(profileFlag);
+    app.add_option("--sample-interval", sampleInterval, "How many microseconds of CPU time to leave between samples.")
+       ->check(CLI::Range(1, 1000000));
     CLI11_PARSE(app, argc, argv);
 
     if (printVersion) {
@@ -50,7 +119,7 @@ int main(int argc, char **argv) {
 
     std::ifstream codeFile{filename, std::ios_base::in | std::ios_base::binary};
     if (!codeFile.is_open()) {
-        std::cerr << "Unable to open '" << argv[1] << "'\n";
+        std::cerr << "Unable to open '" << filename << "'\n";
         return 2;
     }
 
@@ -61,15 +130,69 @@ int main(int argc, char **argv) {
         code.push_back(c);
     }
 
-    try {
-        auto block = gs2::Block::parseBytes(code);
-        auto stack = initialStack();
+    int inputFd = STDIN_FILENO;
+    if (!inputFilename.empty()) {
+        inputFd = openInput(inputFilename);
+        if (inputFd < 0) {
+            std::cerr << "Unable to open '" << inputFilename << "'\n";
+            return 2;
+        }
+    }
+
+    // Everything allocated from the arena is gone by the time it's destroyed
+    std::optional<gs2::Arena> arena;
+    if (useArena) {
+        arena.emplace();
+    }
 
-        gs2::GS2Context gs2{stack};
-        block.execute(gs2);
+    gs2::Profiler profiler;
+    auto profilerOrNull = profile ? &profiler : nullptr;
+
+    std::optional<gs2::Sampler> sampler;
+    if (!sampleFilename.empty()) {
+        try {
+            sampler.emplace(std::chrono::microseconds{sampleInterval});
+        }
+        catch (const gs2::GS2Exception &ex) {
+            std::cerr << ex.what() << '\n';
+            return 1;
+        }
+    }
+    auto samplerOrNull = sampler ? &*sampler : nullptr;
+
+    try {
+        gs2::OptimizationReport report;
+        bool streaming = streamLines && gs2::Block::isLineMode(code);
+        auto block = streaming ? gs2::Block::parseBody(code) : gs2::Block::parseBytes(code);
+        auto program = gs2::Program::compile(block, optimizationLevel, &report);
+
+        if (reportOptimizations) {
+            std::cerr << "Constants folded:        " << report.foldedConstants << '\n'
+                      << "Push-pop pairs removed:  " << report.removedPushPops << '\n'
+                      << "Dup-pop pairs removed:   " << report.removedDupPops << '\n'
+                      << "Blocks inlined:          " << report.inlinedBlocks << '\n';
+        }
 
-        for (const auto &val: stack) {
-            std::cout << val.str();
+        if (streaming) {
+            gs2::LineReader reader{inputFd};
+            gs2::Output output{STDOUT_FILENO};
+            gs2::streamLines(gs2::Block{program, 0}, reader, output, getEngine(engine),
+                             profilerOrNull, samplerOrNull);
+        }
+        else {
+            auto stack = initialStack(inputFd);
+
+            gs2::GS2Context gs2{stack};
+            gs2.setEngine(getEngine(engine));
+            gs2.setThreads(threads > 0 ? threads : gs2::defaultThreadCount());
+            gs2.setProfiler(profilerOrNull);
+            gs2.setSampler(samplerOrNull);
+            gs2::Block{program, 0}.execute(gs2);
+
+            gs2::Output output{STDOUT_FILENO};
+            for (const auto &val: stack) {
+                output.write(val);
+            }
         }
     }
     catch (const gs2::GS2Exception &ex) {
@@ -80,4 +203,23 @@ int main(int argc, char **argv) {
         std::cerr << ex.what() << '\n';
         std::cout.write(reinterpret_cast<char *>(code.data()), code.size());
     }
+
+    if (inputFd != STDIN_FILENO) {
+        closeInput(inputFd);
+    }
+
+    // The profile covers whatever ran before an error too
+    if (profile) {
+        profiler.report(std::cerr);
+    }
+
+    if (sampler) {
+        std::ofstream folded{sampleFilename};
+        if (!folded.is_open()) {
+            std::cerr << "Unable to open '" << sampleFilename << "'\n";
+            return 2;
+        }
+        sampler->writeFolded(folded);
+        sampler->report(std::cerr);
+    }
 }
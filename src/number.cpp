@@ -0,0 +1,195 @@
+#include "number.hpp"
+
+#include <charconv>
+
+namespace gs2 {
+
+bool checkedAdd(int64_t x, int64_t y, int64_t &result) {
+    constexpr auto max = std::numeric_limits<int64_t>::max();
+    constexpr auto min = std::numeric_limits<int64_t>::min();
+
+    if ((y > 0 && x > max - y) || (y < 0 && x < min - y)) {
+        return false;
+    }
+    result = x + y;
+    return true;
+}
+
+bool checkedSub(int64_t x, int64_t y, int64_t &result) {
+    constexpr auto max = std::numeric_limits<int64_t>::max();
+    constexpr auto min = std::numeric_limits<int64_t>::min();
+
+    if ((y < 0 && x > max + y) || (y > 0 && x < min + y)) {
+        return false;
+    }
+    result = x - y;
+    return true;
+}
+
+bool checkedMul(int64_t x, int64_t y, int64_t &result) {
+    constexpr auto max = std::numeric_limits<int64_t>::max();
+    constexpr auto min = std::numeric_limits<int64_t>::min();
+
+    if (x > 0 ? (y > 0 ? x > max / y : y < min / x)
+              : (y > 0 ? x < min / y : x != 0 && y < max / x))
+    {
+        return false;
+    }
+    result = x * y;
+    return true;
+}
+
+Number::Number(): _data(int64_t{0}) {
+}
+
+Number::Number(int64_t num): _data(num) {
+}
+
+Number::Number(BigType num): _data(std::move(num)) {
+    demote();
+}
+
+Number::Number(const std::string &str) {
+    int64_t num;
+    auto begin = str.data();
+    auto end = str.data() + str.size();
+    auto [ptr, err] = std::from_chars(begin, end, num);
+
+    if (err == std::errc{} && ptr == end) {
+        _data = num;
+    }
+    else {
+        _data = BigType(str);
+        demote();
+    }
+}
+
+bool Number::isSmall() const {
+    return std::holds_alternative<int64_t>(_data);
+}
+
+int64_t Number::small() const {
+    return std::get<int64_t>(_data);
+}
+
+Number::BigType Number::big() const {
+    if (isSmall()) {
+        return small();
+    }
+    return std::get<BigType>(_data);
+}
+
+void Number::demote() {
+    const auto &num = std::get<BigType>(_data);
+    if (num >= std::numeric_limits<int64_t>::min() &&
+        num <= std::numeric_limits<int64_t>::max())
+    {
+        _data = num.convert_to<int64_t>();
+    }
+}
+
+Number &Number::operator+=(const Number &rhs) {
+    int64_t result;
+    if (isSmall() && rhs.isSmall() && checkedAdd(small(), rhs.small(), result)) {
+        _data = result;
+    }
+    else {
+        _data = big() + rhs.big();
+        demote();
+    }
+    return *this;
+}
+
+Number &Number::operator-=(const Number &rhs) {
+    int64_t result;
+    if (isSmall() && rhs.isSmall() && checkedSub(small(), rhs.small(), result)) {
+        _data = result;
+    }
+    else {
+        _data = big() - rhs.big();
+        demote();
+    }
+    return *this;
+}
+
+Number &Number::operator*=(const Number &rhs) {
+    int64_t result;
+    if (isSmall() && rhs.isSmall() && checkedMul(small(), rhs.small(), result)) {
+        _data = result;
+    }
+    else {
+        _data = big() * rhs.big();
+        demote();
+    }
+    return *this;
+}
+
+Number &Number::operator/=(const Number &rhs) {
+    // Division by zero is left to cpp_int, so it fails the same way it always
+    // has, and only min / -1 can overflow
+    if (isSmall() && rhs.isSmall() && rhs.small() != 0 &&
+        !(rhs.small() == -1 && small() == std::numeric_limits<int64_t>::min()))
+    {
+        _data = small() / rhs.small();
+    }
+    else {
+        _data = big() / rhs.big();
+        demote();
+    }
+    return *this;
+}
+
+Number &Number::operator%=(const Number &rhs) {
+    if (isSmall() && rhs.isSmall() && rhs.small() != 0) {
+        _data = rhs.small() == -1 ? 0 : small() % rhs.small();
+    }
+    else {
+        _data = big() % rhs.big();
+        demote();
+    }
+    return *this;
+}
+
+Number &Number::operator++() {
+    return *this += 1;
+}
+
+Number &Number::operator--() {
+    return *this -= 1;
+}
+
+Number Number::operator++(int) {
+    auto old = *this;
+    *this += 1;
+    return old;
+}
+
+Number Number::operator--(int) {
+    auto old = *this;
+    *this -= 1;
+    return old;
+}
+
+int compare(const Number &lhs, const Number &rhs) {
+    if (lhs.isSmall() && rhs.isSmall()) {
+        return (lhs.small() > rhs.small()) - (lhs.small() < rhs.small());
+    }
+    return lhs.big().compare(rhs.big());
+}
+
+Number::operator bool() const {
+    return isSmall() ? small() != 0 : !std::get<BigType>(_data).is_zero();
+}
+
+bool Number::fitsInt64() const {
+    return isSmall();
+}
+
+std::string Number::str() const {
+    if (isSmall()) {
+        return std::to_string(small());
+    }
+    return std::get<BigType>(_data).str();
+}
+
+} // namespace gs2
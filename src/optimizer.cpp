@@ -0,0 +1,153 @@
+#include "optimizer.hpp"
+#include "number.hpp"
+#include "program.hpp"
+
+namespace gs2 {
+
+namespace {
+
+bool isCall(const Instruction &insn, uint8_t byte) {
+    return insn.op == Op::Call && insn.byte == byte;
+}
+
+bool isPush(const Instruction &insn) {
+    return insn.op == Op::PushNumber || insn.op == Op::PushConstants ||
+           insn.op == Op::PushBlock;
+}
+
+// Folds x op y into result, unless the result doesn't fit in an immediate or
+// the operation would fail at runtime
+bool foldArithmetic(uint8_t byte, int64_t x, int64_t y, int64_t &result) {
+    switch (byte) {
+        case 0x30:
+            return checkedAdd(x, y, result);
+
+        case 0x32:
+            return checkedMul(x, y, result);
+
+        case 0x34:
+            if (y == 0) {
+                return false;
+            }
+            result = y == -1 ? 0 : x % y;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+class Peephole {
+    private:
+        const std::vector<std::vector<Instruction>> &_blocks;
+        int _level;
+        OptimizationReport &_report;
+
+        std::vector<Instruction> _out;
+
+        bool rewrite() {
+            auto size = _out.size();
+            if (size < 2) {
+                return false;
+            }
+
+            auto &last = _out[size - 1];
+            auto &prev = _out[size - 2];
+
+            // 1 2 + => 3
+            if (size >= 3 && last.op == Op::Call && prev.op == Op::PushNumber &&
+                _out[size - 3].op == Op::PushNumber)
+            {
+                int64_t result;
+                if (foldArithmetic(last.byte, _out[size - 3].immediate, prev.immediate, result)) {
+                    _out.resize(size - 2);
+                    _out.back().immediate = result;
+                    _report.foldedConstants++;
+                    return true;
+                }
+            }
+
+            // "abc" pop =>
+            if (isCall(last, 0x50) && isPush(prev)) {
+                _out.pop_back();
+                if (prev.op == Op::PushConstants && prev.immediate > 1) {
+                    prev.immediate--;
+                }
+                else {
+                    _out.pop_back();
+                }
+                _report.removedPushPops++;
+                return true;
+            }
+
+            // dup pop =>
+            if (_level >= 2 && isCall(last, 0x50) && isCall(prev, 0x40)) {
+                _out.resize(size - 2);
+                _report.removedDupPops++;
+                return true;
+            }
+
+            // {abc} eval => abc
+            if (isCall(last, 0x20) && prev.op == Op::PushBlock) {
+                auto inlined = prev.operand;
+                _out.resize(size - 2);
+                _report.inlinedBlocks++;
+                for (const auto &insn: _blocks[inlined]) {
+                    add(insn);
+                }
+                return true;
+            }
+
+            return false;
+        }
+
+    public:
+        Peephole(const std::vector<std::vector<Instruction>> &blocks, int level,
+                 OptimizationReport &report):
+            _blocks(blocks),
+            _level(level),
+            _report(report)
+        {}
+
+        void add(const Instruction &insn) {
+            _out.push_back(insn);
+            while (rewrite()) {}
+        }
+
+        std::vector<Instruction> take() {
+            return std::move(_out);
+        }
+};
+
+} // anonymous namespace
+
+void optimize(std::vector<Instruction> &code, std::vector<size_t> &blockStarts,
+              int level, OptimizationReport &report)
+{
+    if (level <= 0) {
+        return;
+    }
+
+    // Nested blocks always come after the blocks they're nested in, so going
+    // backwards means a block is already optimized by the time it's inlined
+    std::vector<std::vector<Instruction>> blocks(blockStarts.size());
+
+    for (size_t i = blockStarts.size(); i-- > 0;) {
+        Peephole peephole{blocks, level, report};
+        for (auto insn = code.begin() + blockStarts[i]; insn->op != Op::Return; ++insn) {
+            peephole.add(*insn);
+        }
+        blocks[i] = peephole.take();
+    }
+
+    auto returnInsn = code.back();
+    code.clear();
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blockStarts[i] = code.size();
+        code.insert(code.end(), blocks[i].begin(), blocks[i].end());
+        code.push_back(returnInsn);
+    }
+}
+
+} // namespace gs2
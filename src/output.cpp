@@ -0,0 +1,138 @@
+#include "output.hpp"
+#include "gs2exception.hpp"
+#include "utils.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+
+#ifdef WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace gs2 {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 1 << 20;
+
+// Writes some of the data, returning how much was written or -1 on error
+long writeSome(int fd, const char *data, size_t size) {
+#ifdef WIN32
+    return _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+    return ::write(fd, data, size);
+#endif
+}
+
+} // anonymous namespace
+
+Output::Output(int fd):
+    _fd(fd),
+    _buffer(BUFFER_SIZE),
+    _used(0),
+    _failed(false)
+{}
+
+Output::~Output() {
+    flush();
+}
+
+void Output::write(const Value &value) {
+    if (containsBlock(value)) {
+        throw GS2Exception{"Cannot turn a block to string!"};
+    }
+
+    if (value.isNumber()) {
+        const auto &number = value.getNumber();
+
+        if (number.fitsInt64()) {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), static_cast<int64_t>(number));
+            put(digits, result.ptr - digits);
+        }
+        else {
+            auto str = number.str();
+            put(str.data(), str.size());
+        }
+    }
+    else {
+        writeNested(value);
+    }
+}
+
+// Inside of a list, numbers are written as the character they stand for
+void Output::writeNested(const Value &value) {
+    if (value.isNumber()) {
+        put(static_cast<char>(value.getNumber()));
+        return;
+    }
+
+    const auto &list = value.getList();
+    if (list.isBytes()) {
+        const auto &bytes = list.getBytes();
+        put(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+        return;
+    }
+    else if (list.isRange()) {
+        // Working out a range's numbers avoids filling in its elements
+        const auto &range = list.getRange();
+        for (size_t i = 0; i < range.count; i++) {
+            put(static_cast<char>(Number{range.at(i)}));
+        }
+        return;
+    }
+
+    for (const auto &element: list) {
+        writeNested(element);
+    }
+}
+
+void Output::put(char c) {
+    if (_used == _buffer.size()) {
+        flush();
+    }
+    _buffer[_used++] = c;
+}
+
+void Output::put(const char *data, size_t size) {
+    if (size > _buffer.size() - _used) {
+        flush();
+
+        // Anything too big to buffer is written out directly
+        if (size >= _buffer.size()) {
+            writeAll(data, size);
+            return;
+        }
+    }
+
+    std::copy(data, data + size, _buffer.begin() + _used);
+    _used += size;
+}
+
+void Output::flush() {
+    writeAll(_buffer.data(), _used);
+    _used = 0;
+}
+
+void Output::writeAll(const char *data, size_t size) {
+    while (size > 0 && !_failed) {
+        auto written = writeSome(_fd, data, size);
+
+        if (written < 0) {
+            if (errno != EINTR) {
+                _failed = true;
+            }
+            continue;
+        }
+
+        data += written;
+        size -= written;
+    }
+}
+
+} // namespace gs2
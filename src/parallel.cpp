@@ -0,0 +1,240 @@
+#include "parallel.hpp"
+#include "block.hpp"
+#include "command.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gs2 {
+
+namespace {
+
+// How many values a command needs on the stack, and how many it leaves in
+// their place, as long as none of them are blocks
+struct StackEffect {
+    int pops;
+    int pushes;
+};
+
+bool getStackEffect(const std::vector<uint8_t> &bytes, StackEffect &effect) {
+    switch (bytes[0]) {
+        case 0x00:
+            effect = {0, 0};
+            return true;
+
+        case PUSH_BYTE_CMD:
+        case PUSH_SHORT_CMD:
+        case PUSH_INT_CMD:
+        case PUSH_CHAR_CMD:
+        case 0x0a: case 0x0b: case 0x0d:
+        case 0x84: case 0x85: case 0x86: case 0x87:
+            effect = {0, 1};
+            return true;
+
+        case STRING_START_CMD:
+            if (bytes.back() == 0x05) {
+                auto count = std::count(bytes.begin() + 1, bytes.end() - 1, SPLIT_STRING_BYTE);
+                effect = {0, static_cast<int>(count) + 1};
+                return true;
+            }
+            else if (bytes.back() == 0x06) {
+                effect = {0, 1};
+                return true;
+            }
+            return false;
+
+        case 0x20: case 0x21: case 0x22: case 0x23: case 0x24:
+        case 0x2a: case 0x2b: case 0x2e: case 0x2f:
+        case 0x52: case 0x54: case 0x55: case 0x56: case 0x57:
+        case 0x58: case 0x59: case 0x64: case 0x65:
+            effect = {1, 1};
+            return true;
+
+        case 0x30: case 0x32: case 0x34:
+            effect = {2, 1};
+            return true;
+
+        case 0x40:
+            effect = {1, 2};
+            return true;
+
+        case 0x41:
+            effect = {2, 4};
+            return true;
+
+        case 0x50:
+            effect = {1, 0};
+            return true;
+
+        case 0x51:
+            effect = {2, 0};
+            return true;
+
+        default:
+            if (bytes[0] >= 0x10 && bytes[0] <= 0x1f) {
+                effect = {0, 1};
+                return true;
+            }
+
+            // Includes the counter and empty-block, as well as anything which
+            // isn't a command at all
+            return false;
+    }
+}
+
+// A fixed set of threads which run tasks, so that threads aren't started
+// for every parallel operation
+class ThreadPool {
+    private:
+        std::vector<std::thread> _threads;
+        std::deque<std::function<void()>> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _ready;
+        bool _stopping;
+
+        void work() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock{_mutex};
+                    _ready.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+                    if (_tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+    public:
+        ThreadPool(): _stopping(false) {}
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{_mutex};
+                _stopping = true;
+            }
+            _ready.notify_all();
+            for (auto &thread: _threads) {
+                thread.join();
+            }
+        }
+
+        // Starts more threads if there are fewer than count, and returns how
+        // many there are
+        size_t reserve(size_t count) {
+            std::lock_guard lock{_mutex};
+            while (_threads.size() < count) {
+                _threads.emplace_back([this] { work(); });
+            }
+            return _threads.size();
+        }
+
+        void post(std::function<void()> task) {
+            {
+                std::lock_guard lock{_mutex};
+                _tasks.push_back(std::move(task));
+            }
+            _ready.notify_one();
+        }
+
+        static ThreadPool &get() {
+            static ThreadPool pool;
+            return pool;
+        }
+};
+
+} // anonymous namespace
+
+bool isPureBlock(const Block &block) {
+    int depth = 1;
+
+    for (const auto &command: block.getCommands()) {
+        StackEffect effect;
+        if (!command.isBytes() || !getStackEffect(command.getBytes(), effect)) {
+            return false;
+        }
+        if (depth < effect.pops) {
+            return false;
+        }
+        depth += effect.pushes - effect.pops;
+    }
+
+    return true;
+}
+
+size_t defaultThreadCount() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void parallelFor(size_t count, size_t threads, const std::function<void(size_t)> &fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // The calling thread helps out too, so the pool needs one fewer thread
+    threads = std::clamp<size_t>(threads, 1, count);
+    auto &pool = ThreadPool::get();
+    pool.reserve(threads - 1);
+
+    // A few chunks per thread, so a thread which gets slow elements doesn't
+    // hold everything up
+    auto chunkSize = std::max<size_t>(1, count / (threads * 4));
+    std::atomic<size_t> nextChunk{0};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = threads;
+    size_t failedIndex = count;
+    std::exception_ptr failure;
+
+    auto run = [&] {
+        while (true) {
+            auto start = nextChunk.fetch_add(chunkSize);
+            if (start >= count) {
+                break;
+            }
+
+            for (auto i = start; i < std::min(start + chunkSize, count); i++) {
+                try {
+                    fn(i);
+                }
+                catch (...) {
+                    std::lock_guard lock{mutex};
+                    if (i < failedIndex) {
+                        failedIndex = i;
+                        failure = std::current_exception();
+                    }
+                    break;
+                }
+            }
+        }
+
+        std::lock_guard lock{mutex};
+        if (--running == 0) {
+            finished.notify_one();
+        }
+    };
+
+    for (size_t i = 1; i < threads; i++) {
+        pool.post(run);
+    }
+    run();
+
+    std::unique_lock lock{mutex};
+    finished.wait(lock, [&] { return running == 0; });
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace gs2
@@ -0,0 +1,121 @@
+#include "profiler.hpp"
+#include "command.hpp"
+#include "commands.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace gs2 {
+
+namespace {
+
+double milliseconds(Profiler::Clock::duration time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+} // anonymous namespace
+
+std::string describeCommand(uint8_t byte) {
+    if (auto name = findCommandName(byte); name) {
+        return name;
+    }
+    if (byte >= 0x10 && byte <= 0x1f) {
+        return "push-number";
+    }
+
+    switch (byte) {
+        case PUSH_BYTE_CMD:    return "push-byte";
+        case PUSH_SHORT_CMD:   return "push-short";
+        case PUSH_INT_CMD:     return "push-int";
+        case STRING_START_CMD: return "string";
+        case PUSH_CHAR_CMD:    return "push-char";
+        case BLOCK_START_CMD:  return "block";
+        default:               return "unknown";
+    }
+}
+
+void Profiler::addCommand(uint8_t byte, Clock::duration time) {
+    _commands[byte].count++;
+    _commands[byte].time += time;
+}
+
+void Profiler::addHelper(const char *name, Clock::duration time, bool counted) {
+    auto &entry = _helpers[name];
+    if (counted) {
+        entry.count++;
+    }
+    entry.time += time;
+}
+
+const Profiler::Entry &Profiler::getCommand(uint8_t byte) const {
+    return _commands[byte];
+}
+
+Profiler::Entry Profiler::getHelper(const std::string &name) const {
+    auto it = _helpers.find(name);
+    return it == _helpers.end() ? Entry{} : it->second;
+}
+
+void Profiler::report(std::ostream &out) const {
+    std::vector<std::pair<uint8_t, Entry>> commands;
+    Clock::duration total{};
+
+    for (size_t byte = 0; byte < _commands.size(); byte++) {
+        if (_commands[byte].count > 0) {
+            commands.emplace_back(static_cast<uint8_t>(byte), _commands[byte]);
+            total += _commands[byte].time;
+        }
+    }
+
+    auto slowestFirst = [] (const auto &lhs, const auto &rhs) {
+        return lhs.second.time > rhs.second.time;
+    };
+    std::sort(commands.begin(), commands.end(), slowestFirst);
+
+    auto flags = out.flags();
+    out << std::fixed;
+
+    out << "   time (ms)        %        calls  command\n";
+    for (const auto &[byte, entry]: commands) {
+        double percent = total.count() > 0 ? 100.0 * entry.time.count() / total.count() : 0;
+        out << std::setw(12) << std::setprecision(3) << milliseconds(entry.time)
+            << std::setw(8) << std::setprecision(1) << percent << '%'
+            << std::setw(13) << entry.count
+            << "  0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte)
+            << std::dec << std::setfill(' ') << ' ' << describeCommand(byte) << '\n';
+    }
+
+    if (!_helpers.empty()) {
+        std::vector<std::pair<std::string, Entry>> helpers{_helpers.begin(), _helpers.end()};
+        std::sort(helpers.begin(), helpers.end(), slowestFirst);
+
+        out << "\n   time (ms)                 calls  helper\n";
+        for (const auto &[name, entry]: helpers) {
+            out << std::setw(12) << std::setprecision(3) << milliseconds(entry.time)
+                << std::setw(22) << entry.count << "  " << name << '\n';
+        }
+    }
+
+    out.flags(flags);
+}
+
+ProfileScope::ProfileScope(Profiler *profiler, const char *name, bool counted):
+    _profiler(profiler),
+    _name(name),
+    _counted(counted)
+{
+    if (_profiler) {
+        _start = Profiler::Clock::now();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (_profiler) {
+        _profiler->addHelper(_name, Profiler::Clock::now() - _start, _counted);
+    }
+}
+
+} // namespace gs2
@@ -0,0 +1,209 @@
+#include "program.hpp"
+#include "command.hpp"
+#include "gs2context.hpp"
+#include "gs2exception.hpp"
+
+#include <string>
+
+namespace gs2 {
+
+namespace {
+
+int64_t smallNumber(uint8_t byte) {
+    switch (byte) {
+        case 0x1b: return 100;
+        case 0x1c: return 1000;
+        case 0x1d: return 16;
+        case 0x1e: return 64;
+        case 0x1f: return 256;
+        default:   return byte - 0x10;
+    }
+}
+
+List stringToList(std::vector<uint8_t>::const_iterator begin,
+                  std::vector<uint8_t>::const_iterator end)
+{
+    return List{List::Bytes(begin, end)};
+}
+
+// Builds the value pushed by a command which always pushes the same thing
+Value evaluateConstant(CommandFn command) {
+    List stack;
+    GS2Context gs2{stack};
+    command(gs2);
+    return stack.pop();
+}
+
+} // anonymous namespace
+
+std::shared_ptr<const Program> Program::compile(const Block &block,
+                                               int optimizationLevel,
+                                               OptimizationReport *report)
+{
+    auto program = std::make_shared<Program>();
+
+    // Keep our own copy of the source, so that blocks pushed by the program
+    // can still give back their commands. This has to be a new block, since
+    // the original might hold on to this program.
+    for (const auto &command: block.getCommands()) {
+        program->_source.add(command);
+    }
+    program->_blockSources.push_back(&program->_source);
+
+    // Nested blocks get queued up by compileBlock, and are laid out after
+    // the block they're nested in
+    for (size_t i = 0; i < program->_blockSources.size(); i++) {
+        program->_blockStarts.push_back(program->_code.size());
+        program->compileBlock(*program->_blockSources[i]);
+    }
+
+    OptimizationReport ignoredReport;
+    optimize(program->_code, program->_blockStarts, optimizationLevel,
+             report ? *report : ignoredReport);
+
+    return program;
+}
+
+void Program::compileBlock(const Block &block) {
+    for (const auto &command: block.getCommands()) {
+        if (command.isBlock()) {
+            Instruction insn{Op::PushBlock, BLOCK_START_CMD, 0, 0, nullptr,
+                             static_cast<uint32_t>(command.getOffset())};
+            insn.operand = _blockSources.size();
+            _blockSources.push_back(&command.getBlock());
+            _code.push_back(insn);
+            continue;
+        }
+
+        const auto &bytes = command.getBytes();
+        Instruction insn{Op::PushNumber, bytes[0], 0, 0, nullptr,
+                         static_cast<uint32_t>(command.getOffset())};
+
+        auto requireLength = [&] (size_t length) {
+            if (bytes.size() < length) {
+                throw GS2Exception{"Malformed command: " + std::to_string(bytes[0])};
+            }
+        };
+
+        switch (bytes[0]) {
+            case 0x00:
+                // nops don't need to be compiled at all
+                continue;
+
+            case PUSH_BYTE_CMD:
+                requireLength(2);
+                insn.immediate = bytes[1];
+                break;
+
+            case PUSH_SHORT_CMD:
+                requireLength(3);
+                insn.immediate = static_cast<int16_t>(bytes[1] | (bytes[2] << 8));
+                break;
+
+            case PUSH_INT_CMD:
+                requireLength(5);
+                insn.immediate = static_cast<int32_t>(
+                    bytes[1] | (bytes[2] << 8) | (bytes[3] << 16) |
+                    (static_cast<uint32_t>(bytes[4]) << 24)
+                );
+                break;
+
+            case STRING_START_CMD: {
+                requireLength(2);
+
+                auto end = bytes.end() - 1;
+                if (*end != 0x05 && *end != 0x06) {
+                    insn.op = Op::BadStringEnd;
+                    insn.byte = *end;
+                    break;
+                }
+
+                List strings;
+                auto stringStart = bytes.begin() + 1;
+                for (auto it = stringStart; it != end; ++it) {
+                    if (*it == SPLIT_STRING_BYTE) {
+                        strings.add(stringToList(stringStart, it));
+                        stringStart = it + 1;
+                    }
+                }
+                strings.add(stringToList(stringStart, end));
+
+                if (*end == 0x05) {
+                    for (auto &string: strings) {
+                        addConstant(insn, std::move(string));
+                    }
+                }
+                else {
+                    addConstant(insn, std::move(strings));
+                }
+                break;
+            }
+
+            case PUSH_CHAR_CMD:
+                requireLength(2);
+                addConstant(insn, stringToList(bytes.begin() + 1, bytes.begin() + 2));
+                break;
+
+            case 0x0a: // new-line
+            case 0x0d: // space
+            case 0x84: // uppercase-alphabet
+            case 0x85: // lowercase-alphabet
+            case 0x86: // ascii-digits
+            case 0x87: // printable-ascii
+                addConstant(insn, evaluateConstant(findCommand(bytes[0])));
+                break;
+
+            default:
+                if (bytes[0] >= 0x10 && bytes[0] <= 0x1f) {
+                    insn.immediate = smallNumber(bytes[0]);
+                }
+                else if (auto fn = findCommand(bytes[0]); fn) {
+                    insn.op = Op::Call;
+                    insn.command = fn;
+                }
+                else {
+                    insn.op = Op::BadCommand;
+                }
+                break;
+        }
+
+        _code.push_back(insn);
+    }
+
+    _code.push_back({Op::Return, BLOCK_END_CMD, 0, 0, nullptr, 0});
+}
+
+void Program::addConstant(Instruction &insn, Value value) {
+    if (insn.op != Op::PushConstants) {
+        insn.op = Op::PushConstants;
+        insn.operand = _constants.size();
+    }
+    insn.immediate++;
+    _constants.push_back(std::move(value));
+}
+
+void Program::execute(GS2Context &gs2, size_t blockIndex) const {
+    Block{shared_from_this(), blockIndex}.execute(gs2);
+}
+
+const std::vector<Instruction> &Program::getCode() const {
+    return _code;
+}
+
+size_t Program::getBlockCount() const {
+    return _blockStarts.size();
+}
+
+size_t Program::getBlockStart(size_t blockIndex) const {
+    return _blockStarts[blockIndex];
+}
+
+const Block &Program::getSource(size_t blockIndex) const {
+    return *_blockSources[blockIndex];
+}
+
+const Value &Program::getConstant(size_t constantIndex) const {
+    return _constants[constantIndex];
+}
+
+} // namespace gs2
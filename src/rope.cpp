@@ -0,0 +1,341 @@
+#include "rope.hpp"
+#include "shared.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace gs2 {
+
+namespace {
+
+// Leaves are kept short, so that building a new one to change it only copies
+// a handful of values
+constexpr size_t MAX_LEAF_SIZE = 32;
+
+// Bytes are much cheaper to copy than values, so leaves holding bytes can be
+// longer for about the same cost
+constexpr size_t MAX_BYTE_LEAF_SIZE = 1024;
+
+} // anonymous namespace
+
+struct Rope::Node {
+    using Ptr = std::shared_ptr<Node>;
+
+    size_t size = 0;
+
+    // Leaves have a height of 0, and hold their elements in values, or in
+    // bytes if holdsBytes is set, so that runs of bytes stay as compact as
+    // they are in a byte string. Every other node has both a left and a right
+    // child, whose heights differ by at most one.
+    int height = 0;
+    bool holdsBytes = false;
+    Ptr left;
+    Ptr right;
+    std::pmr::vector<Value> values;
+    std::pmr::vector<uint8_t> bytes;
+
+    bool isLeaf() const {
+        return height == 0;
+    }
+
+    size_t maxLeafSize() const {
+        return holdsBytes ? MAX_BYTE_LEAF_SIZE : MAX_LEAF_SIZE;
+    }
+
+    const Value &at(size_t index) const {
+        return holdsBytes ? byteValue(bytes[index]) : values[index];
+    }
+
+    static Ptr leaf(std::pmr::vector<Value> values) {
+        auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{});
+        node->size = values.size();
+        node->values = std::move(values);
+        return node;
+    }
+
+    static Ptr leaf(std::pmr::vector<uint8_t> bytes) {
+        auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{});
+        node->size = bytes.size();
+        node->holdsBytes = true;
+        node->bytes = std::move(bytes);
+        return node;
+    }
+
+    // A leaf holding just one value, as bytes if it's a byte
+    static Ptr leaf(Value value) {
+        if (isByte(value)) {
+            return leaf(std::pmr::vector<uint8_t>{static_cast<uint8_t>(value.getNumber())});
+        }
+
+        std::pmr::vector<Value> values;
+        values.push_back(std::move(value));
+        return leaf(std::move(values));
+    }
+
+    static Ptr branch(Ptr left, Ptr right) {
+        auto node = std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>{});
+        node->size = left->size + right->size;
+        node->height = std::max(left->height, right->height) + 1;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+
+    // Joins two balanced trees whose heights differ by at most two
+    static Ptr balance(Ptr left, Ptr right) {
+        if (left->height > right->height + 1) {
+            if (left->left->height >= left->right->height) {
+                return branch(left->left, branch(left->right, std::move(right)));
+            }
+            const auto &middle = left->right;
+            return branch(branch(left->left, middle->left), branch(middle->right, std::move(right)));
+        }
+        else if (right->height > left->height + 1) {
+            if (right->right->height >= right->left->height) {
+                return branch(branch(std::move(left), right->left), right->right);
+            }
+            const auto &middle = right->left;
+            return branch(branch(std::move(left), middle->left), branch(middle->right, right->right));
+        }
+        return branch(std::move(left), std::move(right));
+    }
+
+    // Joins two balanced trees of any height, in time proportional to the
+    // difference between their heights. A leaf joined to a larger tree is
+    // merged into the leaf at its edge if there's room. Leaves of bytes are
+    // only merged into leaves of values when the result is short.
+    static Ptr join(Ptr left, Ptr right) {
+        if (!left) {
+            return right;
+        }
+        else if (!right) {
+            return left;
+        }
+
+        if (left->isLeaf() && right->isLeaf()) {
+            auto size = left->size + right->size;
+
+            if (left->holdsBytes && right->holdsBytes) {
+                if (size > MAX_BYTE_LEAF_SIZE) {
+                    return branch(std::move(left), std::move(right));
+                }
+
+                std::pmr::vector<uint8_t> bytes;
+                bytes.reserve(size);
+                bytes.insert(bytes.end(), left->bytes.begin(), left->bytes.end());
+                bytes.insert(bytes.end(), right->bytes.begin(), right->bytes.end());
+                return leaf(std::move(bytes));
+            }
+
+            if (size > MAX_LEAF_SIZE) {
+                return branch(std::move(left), std::move(right));
+            }
+
+            std::pmr::vector<Value> values;
+            values.reserve(size);
+            collect(*left, values);
+            collect(*right, values);
+            return leaf(std::move(values));
+        }
+
+        if (left->height > right->height + 1 || right->isLeaf()) {
+            return balance(left->left, join(left->right, std::move(right)));
+        }
+        else if (right->height > left->height + 1 || left->isLeaf()) {
+            return balance(join(std::move(left), right->left), right->right);
+        }
+        return branch(std::move(left), std::move(right));
+    }
+
+    // Splits a tree into its first index elements and the rest
+    static std::pair<Ptr, Ptr> split(const Ptr &node, size_t index) {
+        if (index == 0) {
+            return {nullptr, node};
+        }
+        else if (index >= node->size) {
+            return {node, nullptr};
+        }
+
+        if (node->isLeaf() && node->holdsBytes) {
+            auto middle = node->bytes.begin() + index;
+            return {
+                leaf(std::pmr::vector<uint8_t>(node->bytes.begin(), middle)),
+                leaf(std::pmr::vector<uint8_t>(middle, node->bytes.end())),
+            };
+        }
+        else if (node->isLeaf()) {
+            auto middle = node->values.begin() + index;
+            return {
+                leaf(std::pmr::vector<Value>(node->values.begin(), middle)),
+                leaf(std::pmr::vector<Value>(middle, node->values.end())),
+            };
+        }
+
+        if (index <= node->left->size) {
+            auto [first, second] = split(node->left, index);
+            return {std::move(first), join(std::move(second), node->right)};
+        }
+
+        auto [first, second] = split(node->right, index - node->left->size);
+        return {join(node->left, std::move(first)), std::move(second)};
+    }
+
+    static Ptr build(std::pmr::vector<Value> &values, size_t start, size_t end) {
+        if (end - start <= MAX_LEAF_SIZE) {
+            return leaf(std::pmr::vector<Value>(
+                std::make_move_iterator(values.begin() + start),
+                std::make_move_iterator(values.begin() + end)
+            ));
+        }
+
+        auto middle = start + (end - start) / 2;
+        return branch(build(values, start, middle), build(values, middle, end));
+    }
+
+    static Ptr build(const std::pmr::vector<uint8_t> &bytes, size_t start, size_t end) {
+        if (end - start <= MAX_BYTE_LEAF_SIZE) {
+            return leaf(std::pmr::vector<uint8_t>(bytes.begin() + start, bytes.begin() + end));
+        }
+
+        auto middle = start + (end - start) / 2;
+        return branch(build(bytes, start, middle), build(bytes, middle, end));
+    }
+
+    // Adds a value to the leaf at one end of the tree without building any
+    // new nodes, if none of the nodes on the way there are shared
+    static bool addInPlace(Ptr &root, Value &value, bool atFront) {
+        std::vector<Node *> path;
+
+        for (auto *node = &root; ; node = atFront ? &(*node)->left : &(*node)->right) {
+            if (!isUnique(*node)) {
+                return false;
+            }
+            path.push_back(node->get());
+
+            if ((*node)->isLeaf()) {
+                break;
+            }
+        }
+
+        auto leaf = path.back();
+        if (leaf->size >= leaf->maxLeafSize()) {
+            return false;
+        }
+
+        if (leaf->holdsBytes) {
+            if (!isByte(value)) {
+                return false;
+            }
+            auto &bytes = leaf->bytes;
+            bytes.insert(atFront ? bytes.begin() : bytes.end(), static_cast<uint8_t>(value.getNumber()));
+        }
+        else {
+            auto &values = leaf->values;
+            values.insert(atFront ? values.begin() : values.end(), std::move(value));
+        }
+        for (auto node: path) {
+            node->size++;
+        }
+        return true;
+    }
+
+    static void collect(const Node &node, std::pmr::vector<Value> &values) {
+        if (node.isLeaf() && node.holdsBytes) {
+            for (auto byte: node.bytes) {
+                values.emplace_back(byteValue(byte));
+            }
+            return;
+        }
+        else if (node.isLeaf()) {
+            values.insert(values.end(), node.values.begin(), node.values.end());
+            return;
+        }
+        collect(*node.left, values);
+        collect(*node.right, values);
+    }
+};
+
+Rope::Rope() {}
+
+Rope::Rope(std::shared_ptr<Node> root): _root(std::move(root)) {}
+
+Rope::Rope(std::pmr::vector<Value> values) {
+    if (!values.empty()) {
+        _root = Node::build(values, 0, values.size());
+    }
+}
+
+Rope::Rope(const std::pmr::vector<uint8_t> &bytes) {
+    if (!bytes.empty()) {
+        _root = Node::build(bytes, 0, bytes.size());
+    }
+}
+
+Rope::~Rope() {}
+
+void Rope::append(Value value) {
+    if (_root && Node::addInPlace(_root, value, false)) {
+        return;
+    }
+
+    _root = Node::join(std::move(_root), Node::leaf(std::move(value)));
+}
+
+void Rope::prepend(Value value) {
+    if (_root && Node::addInPlace(_root, value, true)) {
+        return;
+    }
+
+    _root = Node::join(Node::leaf(std::move(value)), std::move(_root));
+}
+
+void Rope::concat(const Rope &rope) {
+    // Copy the other root first, in case it's our own
+    auto other = rope._root;
+    _root = Node::join(std::move(_root), std::move(other));
+}
+
+Rope Rope::splitAt(size_t index) {
+    if (!_root) {
+        return {};
+    }
+
+    auto [first, second] = Node::split(_root, index);
+    _root = std::move(first);
+    return Rope{std::move(second)};
+}
+
+const Value &Rope::operator[](size_t index) const {
+    auto node = _root.get();
+
+    while (!node->isLeaf()) {
+        if (index < node->left->size) {
+            node = node->left.get();
+        }
+        else {
+            index -= node->left->size;
+            node = node->right.get();
+        }
+    }
+
+    return node->at(index);
+}
+
+size_t Rope::size() const {
+    return _root ? _root->size : 0;
+}
+
+std::pmr::vector<Value> Rope::values() const {
+    std::pmr::vector<Value> values;
+
+    if (_root) {
+        values.reserve(_root->size);
+        Node::collect(*_root, values);
+    }
+
+    return values;
+}
+
+} // namespace gs2
@@ -0,0 +1,148 @@
+#include "sampler.hpp"
+#include "gs2exception.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+#ifndef WIN32
+    #include <signal.h>
+    #include <sys/time.h>
+#endif
+
+namespace gs2 {
+
+namespace {
+
+// Set by the timer signal, which may be handled on any thread
+std::atomic<bool> due{false};
+
+static_assert(std::atomic<bool>::is_always_lock_free,
+              "The signal handler can only use lock-free atomics");
+
+bool running = false;
+
+#ifndef WIN32
+
+struct sigaction previousAction;
+
+void onTimer(int) {
+    due.store(true, std::memory_order_relaxed);
+}
+
+void setTimer(std::chrono::microseconds interval) {
+    itimerval timer{};
+    timer.it_interval.tv_sec = static_cast<time_t>(interval.count() / 1000000);
+    timer.it_interval.tv_usec = static_cast<suseconds_t>(interval.count() % 1000000);
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+#endif
+
+std::string label(const SampleFrame &frame) {
+    if (frame.helper) {
+        return frame.helper;
+    }
+    return describeCommand(frame.byte) + " @" + std::to_string(frame.offset);
+}
+
+} // anonymous namespace
+
+Sampler::Sampler(std::chrono::microseconds interval): _total(0) {
+#ifdef WIN32
+    (void) interval;
+    throw GS2Exception{"Sampling isn't supported on Windows!"};
+#else
+    if (running) {
+        throw GS2Exception{"Only one sampler can run at a time!"};
+    }
+    if (interval.count() <= 0) {
+        throw GS2Exception{"The sampling interval has to be positive!"};
+    }
+
+    struct sigaction action{};
+    action.sa_handler = onTimer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previousAction);
+
+    due.store(false, std::memory_order_relaxed);
+    running = true;
+    setTimer(interval);
+#endif
+}
+
+Sampler::~Sampler() {
+#ifndef WIN32
+    // A signal raised by the timer is delivered before setitimer returns, so
+    // none can arrive once the old handler is back
+    setTimer(std::chrono::microseconds{0});
+    sigaction(SIGPROF, &previousAction, nullptr);
+    running = false;
+#endif
+}
+
+bool Sampler::isDue() {
+    return due.load(std::memory_order_relaxed);
+}
+
+void Sampler::record(const std::vector<SampleFrame> &path) {
+    due.store(false, std::memory_order_relaxed);
+
+    if (path.empty()) {
+        return;
+    }
+
+    std::string stack;
+    for (const auto &frame: path) {
+        if (!stack.empty()) {
+            stack += ';';
+        }
+        stack += label(frame);
+    }
+
+    _stacks[stack]++;
+    _total++;
+
+    const auto &top = path.back();
+    if (!top.helper) {
+        _offsets[{top.offset, top.byte}]++;
+    }
+}
+
+uint64_t Sampler::getTotal() const {
+    return _total;
+}
+
+void Sampler::writeFolded(std::ostream &out) const {
+    for (const auto &[stack, count]: _stacks) {
+        out << stack << ' ' << count << '\n';
+    }
+}
+
+void Sampler::report(std::ostream &out, size_t limit) const {
+    std::vector<std::pair<std::pair<size_t, uint8_t>, uint64_t>> offsets{_offsets.begin(), _offsets.end()};
+    std::stable_sort(offsets.begin(), offsets.end(), [] (const auto &lhs, const auto &rhs) {
+        return lhs.second > rhs.second;
+    });
+    offsets.resize(std::min(offsets.size(), limit));
+
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+
+    out << "     samples        %    offset  command\n";
+    for (const auto &[place, count]: offsets) {
+        out << std::setw(12) << count
+            << std::setw(8) << 100.0 * count / _total << '%'
+            << std::setw(10) << place.first
+            << "  " << describeCommand(place.second) << '\n';
+    }
+
+    out.flags(flags);
+}
+
+} // namespace gs2
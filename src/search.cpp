@@ -0,0 +1,76 @@
+#include "search.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(GS2_NO_SIMD)
+    #define GS2_X86_SIMD 1
+    #include <immintrin.h>
+#else
+    #define GS2_X86_SIMD 0
+#endif
+
+namespace gs2 {
+
+namespace {
+
+using FindByteFn = const uint8_t *(*)(const uint8_t *, const uint8_t *, uint8_t);
+
+const uint8_t *findByteScalar(const uint8_t *begin, const uint8_t *end, uint8_t byte) {
+    return std::find(begin, end, byte);
+}
+
+#if GS2_X86_SIMD
+
+__attribute__((target("sse2")))
+const uint8_t *findByteSse2(const uint8_t *begin, const uint8_t *end, uint8_t byte) {
+    auto needle = _mm_set1_epi8(static_cast<char>(byte));
+
+    for (; end - begin >= 16; begin += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+
+    return findByteScalar(begin, end, byte);
+}
+
+__attribute__((target("avx2")))
+const uint8_t *findByteAvx2(const uint8_t *begin, const uint8_t *end, uint8_t byte) {
+    auto needle = _mm256_set1_epi8(static_cast<char>(byte));
+
+    for (; end - begin >= 32; begin += 32) {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+
+    return findByteSse2(begin, end, byte);
+}
+
+#endif
+
+FindByteFn chooseFindByte() {
+#if GS2_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findByteAvx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        return findByteSse2;
+    }
+#endif
+    return findByteScalar;
+}
+
+} // anonymous namespace
+
+const uint8_t *findByte(const uint8_t *begin, const uint8_t *end, uint8_t byte) {
+    static const auto find = chooseFindByte();
+    return find(begin, end, byte);
+}
+
+} // namespace gs2
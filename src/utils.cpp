@@ -1,15 +1,14 @@
 #include "utils.hpp"
 #include "gs2exception.hpp"
+#include "number.hpp"
+#include "parallel.hpp"
+#include "search.hpp"
 #include "value.hpp"
 
 namespace gs2 {
 
 List makeList(const std::string &str) {
-    List list;
-    for (auto c: str) {
-        list.add(c);
-    }
-    return list;
+    return List{List::Bytes(str.begin(), str.end())};
 }
 
 std::string makeString(Value value) {
@@ -20,7 +19,12 @@ std::string makeString(Value value) {
         return str;
     }
     else if (value.isList()) {
-        for (const auto &val: value.getList()) {
+        const auto &list = value.getList();
+        if (list.isBytes()) {
+            return std::string(list.getBytes().begin(), list.getBytes().end());
+        }
+
+        for (const auto &val: list) {
             if (!val.isNumber()) {
                 throw GS2Exception{"Unable to convert non-number inside list to string!"};
             }
@@ -38,57 +42,92 @@ List join(List toJoin, const List &separator) {
 
     for (size_t i = 0; i < toJoin.size(); i++) {
         if (i > 0) {
-            for (const auto &val: separator) {
-                joined.add(val);
-            }
+            joined.concat(separator);
         }
         if (toJoin[i].isList()) {
-            for (auto &item: toJoin[i].getList()) {
-                joined.add(std::move(item));
-            }
+            joined.concat(toJoin[i].getList());
         }
         else {
-            joined.add(std::move(toJoin[i]));
+            joined.add(toJoin.take(i));
         }
     }
 
     return joined;
 }
 
-bool subListEqual(const List &list1, const List &list2, size_t start) {
-    if (start + list1.size() > list2.size()) {
-        return false;
-    }
+// Splitting a byte string on a single byte doesn't need to compare any
+// Values, so the bytes are scanned for the separator directly
+List splitBytes(List::ByteView bytes, uint8_t sep, bool clean) {
+    List result;
+    auto begin = bytes.data();
+    auto end = begin + bytes.size();
 
-    for (size_t i = 0; i < list1.size(); i++) {
-        if (list1[i] != list2[i + start]) {
-            return false;
+    while (true) {
+        auto found = findByte(begin, end, sep);
+        if (!clean || found != begin) {
+            result.add(List{List::Bytes(begin, found)});
         }
-    }
 
-    return true;
+        if (found == end) {
+            return result;
+        }
+        begin = found + 1;
+    }
 }
 
 List split(List toSplit, const List &sep, bool clean) {
-    List result;
-    result.add(List{});
-
-    for (size_t i = 0; i < toSplit.size(); i++) {
-        if (subListEqual(sep, toSplit, i)) {
-            if (!clean || !result.back().getList().empty()) {
-                result.add(List{});
-            }
-            i += sep.size() - 1;
+    // There's nothing to scan for any separator, even an empty one
+    if (toSplit.empty()) {
+        List result;
+        if (!clean) {
+            result.add(List{});
         }
-        else {
-            result.back().getList().add(std::move(toSplit[i]));
+        return result;
+    }
+
+    if (sep.empty()) {
+        throw GS2Exception{"Cannot split on an empty list!"};
+    }
+
+    if (toSplit.isBytes() && sep.size() == 1) {
+        const auto &sepVal = sep[0];
+        if (sepVal.isNumber() && sepVal.getNumber() >= 0 && sepVal.getNumber() <= 0xff) {
+            return splitBytes(toSplit.getBytes(), static_cast<uint8_t>(sepVal.getNumber()), clean);
         }
     }
 
-    if (clean && result.back().getList().empty()) {
-        result.pop();
+    List result;
+    size_t pieceStart = 0;
+
+    if (toSplit.isBytes() && sep.isBytes()) {
+        const uint8_t *bytes = toSplit.getBytes().data();
+        const uint8_t *sepBytes = sep.getBytes().data();
+
+        auto addPiece = [&] (size_t end) {
+            if (!clean || end > pieceStart) {
+                result.add(List{List::Bytes(bytes + pieceStart, bytes + end)});
+            }
+            pieceStart = end + sep.size();
+        };
+
+        findEach(bytes, toSplit.size(), sepBytes, sep.size(), addPiece);
+        addPiece(toSplit.size());
+        return result;
     }
 
+    auto addPiece = [&] (size_t end) {
+        if (!clean || end > pieceStart) {
+            List piece;
+            for (auto i = pieceStart; i < end; i++) {
+                piece.add(toSplit.take(i));
+            }
+            result.add(std::move(piece));
+        }
+        pieceStart = end + sep.size();
+    };
+
+    findEach(toSplit, toSplit.size(), sep, sep.size(), addPiece);
+    addPiece(toSplit.size());
     return result;
 }
 
@@ -97,20 +136,134 @@ List stepOver(List list, int64_t stepSize) {
         throw GS2Exception{"Step size cannot be zero!"};
     }
 
+    // Every nth element of a range is another range
+    if (list.isRange()) {
+        const auto &range = list.getRange();
+        int64_t step;
+
+        if (checkedMul(range.step, stepSize, step)) {
+            uint64_t stride = stepSize > 0 ? stepSize : -static_cast<uint64_t>(stepSize);
+            auto count = (range.count - 1) / stride + 1;
+            auto start = stepSize > 0 ? range.at(0) : range.at(range.count - 1);
+            return List{List::Range{start, step, count}};
+        }
+    }
+
     List newList;
 
     if (stepSize > 0) {
         for (size_t i = 0; i < list.size(); i += stepSize) {
-            newList.add(std::move(list[i]));
+            newList.add(list.take(i));
         }
     }
     else {
         for (size_t i = list.size() - 1; i < list.size(); i += stepSize) {
-            newList.add(std::move(list[i]));
+            newList.add(list.take(i));
         }
     }
 
     return newList;
 }
 
+bool containsBlock(const Value &value) {
+    if (value.isBlock()) {
+        return true;
+    }
+    else if (value.isList() && !value.getList().isBytes() && !value.getList().isRange()) {
+        for (const auto &element: value.getList()) {
+            if (containsBlock(element)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+namespace {
+
+// Combines the numbers in a non-empty list with op, as a balanced tree
+template <typename Op>
+Number reduceNumbers(const List &list, size_t threads, Op op) {
+    auto leaf = [&list, &op] (size_t begin, size_t end) {
+        Number result;
+
+        for (auto i = begin; i < end; i++) {
+            // A range's numbers are worked out rather than filled in
+            Number rangeNumber;
+            const Number *number = &rangeNumber;
+
+            if (list.isRange()) {
+                rangeNumber = list.getRange().at(i);
+            }
+            else if (list[i].isNumber()) {
+                number = &list[i].getNumber();
+            }
+            else {
+                throw GS2Exception{"Cannot sum a list with non-numbers!"};
+            }
+
+            if (i == begin) {
+                result = *number;
+            }
+            else {
+                op(result, *number);
+            }
+        }
+
+        return result;
+    };
+
+    return treeReduce<Number>(list.size(), threads, leaf, op);
+}
+
+// Whether any of a range's numbers is zero
+bool rangeHasZero(const List::Range &range) {
+    if (range.step == 0) {
+        return range.start == 0;
+    }
+
+    // Zero would be at index -start / step
+    Number offset = 0;
+    offset -= range.start;
+    if (offset % range.step != 0) {
+        return false;
+    }
+
+    auto index = offset / range.step;
+    return index >= 0 && index < range.count;
+}
+
+} // anonymous namespace
+
+Number sumList(const List &list, size_t threads) {
+    if (list.empty()) {
+        return 0;
+    }
+
+    if (list.isRange()) {
+        // count * start + step * (0 + 1 + ... + count - 1)
+        const auto &range = list.getRange();
+        Number count = range.count;
+        return count * range.start + range.step * (count * (count - 1) / 2);
+    }
+
+    return reduceNumbers(list, threads, [] (Number &lhs, const Number &rhs) {
+        lhs += rhs;
+    });
+}
+
+Number productList(const List &list, size_t threads) {
+    if (list.empty()) {
+        return 1;
+    }
+
+    if (list.isRange() && rangeHasZero(list.getRange())) {
+        return 0;
+    }
+
+    return reduceNumbers(list, threads, [] (Number &lhs, const Number &rhs) {
+        lhs *= rhs;
+    });
+}
+
 } // namespace gs2
@@ -2,6 +2,7 @@
 #include "gs2exception.hpp"
 
 #include <type_traits>
+#include <vector>
 
 namespace gs2 {
 
@@ -78,8 +79,22 @@ std::string Value::str(bool nested) const {
         using T = std::decay_t<decltype(arg)>;
 
         if constexpr (std::is_same_v<T, List>) {
+            if (arg.isBytes()) {
+                return std::string(arg.getBytes().begin(), arg.getBytes().end());
+            }
+
             std::string str;
 
+            // Working out a range's numbers avoids filling in its elements
+            if (arg.isRange()) {
+                const auto &range = arg.getRange();
+                str.reserve(range.count);
+                for (size_t i = 0; i < range.count; i++) {
+                    str += static_cast<char>(Number{range.at(i)});
+                }
+                return str;
+            }
+
             for (const auto& val: arg) {
                 str += val.str(true);
             }
@@ -102,4 +117,24 @@ std::string Value::str(bool nested) const {
     }, _data);
 }
 
+const Value &byteValue(uint8_t byte) {
+    static const auto values = [] {
+        std::vector<Value> values;
+        for (int i = 0; i < 256; i++) {
+            values.emplace_back(i);
+        }
+        return values;
+    }();
+
+    return values[byte];
+}
+
+bool isByte(const Value &value) {
+    if (!value.isNumber() || !value.getNumber().fitsInt64()) {
+        return false;
+    }
+    auto num = static_cast<int64_t>(value.getNumber());
+    return num >= 0 && num <= 0xff;
+}
+
 } // namespace gs2
@@ -85,6 +85,14 @@ TEST_CASE("Testing different modes") {
     REQUIRE(blockCommands[1].isBytes());
     CHECK(blockCommands[1].getBytes() == std::vector<uint8_t>{ '?' });
 
+    // The body of a line mode program is just the mapped block
+    std::vector<uint8_t> lineCode{0x30, 0x04, 'H', 'e', 'y', 0x05, '?'};
+    CHECK(gs2::Block::isLineMode(lineCode));
+    CHECK_FALSE(gs2::Block::isLineMode({0x00, 0x30}));
+    auto bodyCommands = gs2::Block::parseBody(lineCode).getCommands();
+    REQUIRE(bodyCommands.size() == 2);
+    CHECK(bodyCommands[0].getBytes() == blockCommands[0].getBytes());
+    CHECK(bodyCommands[1].getBytes() == blockCommands[1].getBytes());
 }
 
 TEST_CASE("Testing block parses") {
@@ -149,3 +157,93 @@ TEST_CASE("Testing block parses") {
     REQUIRE(innerBlock[1].isBytes());
     CHECK(innerBlock[1].getBytes() == std::vector<uint8_t>{ '!' });
 }
+
+TEST_CASE("Testing command source offsets") {
+    auto commands = parseBlock("\x01\x05\x08\x40\x09\xfe\x30").getCommands();
+
+    REQUIRE(commands.size() == 5);
+    CHECK(commands[0].getOffset() == 0);
+
+    // Blocks, and the commands which finish them, are placed where the block
+    // was opened
+    REQUIRE(commands[1].isBlock());
+    CHECK(commands[1].getOffset() == 2);
+    CHECK(commands[1].getBlock().getCommands()[0].getOffset() == 3);
+    CHECK(commands[2].getOffset() == 2);
+
+    REQUIRE(commands[3].isBlock());
+    CHECK(commands[3].getOffset() == 5);
+    CHECK(commands[3].getBlock().getCommands()[0].getOffset() == 6);
+    REQUIRE(commands[4].getBytes() == std::vector<uint8_t>{0x34});
+    CHECK(commands[4].getOffset() == 5);
+
+    // A string without a start begins at the start of the file
+    commands = parseBlock("ab\x05\x40").getCommands();
+    REQUIRE(commands.size() == 2);
+    CHECK(commands[0].getOffset() == 0);
+    CHECK(commands[1].getOffset() == 3);
+}
+
+TEST_CASE("Testing block sharing") {
+    gs2::Block block;
+    block.add(std::vector<uint8_t>{'a'});
+
+    // Adding to a copy of a block shouldn't change the original
+    auto copy = block;
+    copy.add(std::vector<uint8_t>{'b'});
+
+    REQUIRE(block.getCommands().size() == 1);
+    REQUIRE(copy.getCommands().size() == 2);
+    CHECK(copy.getCommands()[0].getBytes() == std::vector<uint8_t>{'a'});
+    CHECK(copy.getCommands()[1].getBytes() == std::vector<uint8_t>{'b'});
+
+    CHECK(block != copy);
+    CHECK_FALSE(copy != copy);
+}
+
+TEST_CASE("Testing block concatenation") {
+    gs2::Block first, second, third;
+    first.add(std::vector<uint8_t>{'a'});
+    second.add(std::vector<uint8_t>{'b'});
+    third.add(std::vector<uint8_t>{'c'});
+
+    auto joined = first;
+    joined.concat(second);
+    joined.concat(gs2::Block{});
+    joined.concat(third);
+
+    auto &commands = joined.getCommands();
+    REQUIRE(commands.size() == 3);
+    CHECK(commands[0].getBytes() == std::vector<uint8_t>{'a'});
+    CHECK(commands[1].getBytes() == std::vector<uint8_t>{'b'});
+    CHECK(commands[2].getBytes() == std::vector<uint8_t>{'c'});
+
+    // The pieces of the concatenation are left alone
+    CHECK(first.getCommands().size() == 1);
+    CHECK(second.getCommands().size() == 1);
+
+    // Adding to a concatenation works like adding to any other block
+    joined.add(std::vector<uint8_t>{'d'});
+    CHECK(joined.getCommands().size() == 4);
+
+    // Concatenating an empty block gives back the other block
+    gs2::Block empty;
+    empty.concat(first);
+    CHECK_FALSE(empty != first);
+}
+
+TEST_CASE("Testing long chains of block concatenations") {
+    gs2::Block piece;
+    piece.add(std::vector<uint8_t>{'a'});
+
+    // Both flattening and destroying the chain have to work without
+    // recursing once per link
+    {
+        gs2::Block joined;
+        for (int i = 0; i < 1000000; i++) {
+            joined.concat(piece);
+        }
+        CHECK(joined.getCommands().size() == 1000000);
+    }
+    CHECK(piece.getCommands().size() == 1);
+}
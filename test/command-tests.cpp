@@ -8,6 +8,7 @@
 #include "utils.hpp"
 
 #include <iostream>
+#include <limits>
 
 gs2::List getResult(const std::string &code, const std::vector<gs2::Value> &initialStack = {}) {
     std::vector<uint8_t> codeBytes{code.begin(), code.end()};
@@ -425,6 +426,19 @@ TEST_CASE("Test 0x2f - range1") {
         CHECK(list[i].getNumber() == i + 1);
     }
 
+    // Large ranges can be measured and read from without being built
+    result = getResult("\x2f\x2e", {int64_t{1000000000000}});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 1000000000000);
+
+    result = getResult("\x2f\x21", {int64_t{1000000000000}});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 1);
+
+    result = getResult("\x2f\x24", {int64_t{1000000000000}});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 1000000000000);
+
     result = getResult("\x2f", {-44});
     REQUIRE(result.size() == 1);
     REQUIRE(result[0].isList());
@@ -614,6 +628,12 @@ TEST_CASE("Test 0x34 - mod / step / clean-split / map") {
         compareString(list[1].getList(), "abl");
         REQUIRE(list[2].isList());
         compareString(list[2].getList(), "bl");
+
+        // Splitting an empty list on an empty list leaves nothing
+        result = getResult("\x34", {gs2::List{}, gs2::List{}});
+        REQUIRE(result.size() == 1);
+        REQUIRE(result[0].isList());
+        CHECK(result[0].getList().empty());
     }
 
     SECTION("map") {
@@ -825,6 +845,28 @@ TEST_CASE("Test 0x57 - read-nums") {
         CHECK(numList[2].getNumber() == 13);
         REQUIRE(numList[3].isNumber());
         CHECK(numList[3].getNumber() == -14);
+
+        // Minus signs only count right before a number, and numbers of any
+        // length are read in decimal
+        result = getResult("5-3--7 - 8 0012 -9223372036854775808 123456789012345678901234567890\x05\x57");
+        REQUIRE(result.size() == 1);
+        REQUIRE(result[0].isList());
+        numList = result[0].getList();
+        REQUIRE(numList.size() == 7);
+        CHECK(numList[0].getNumber() == 5);
+        CHECK(numList[1].getNumber() == -3);
+        CHECK(numList[2].getNumber() == -7);
+        CHECK(numList[3].getNumber() == 8);
+        CHECK(numList[4].getNumber() == 12);
+        CHECK(numList[5].getNumber() == std::numeric_limits<int64_t>::min());
+        CHECK(numList[5].getNumber().fitsInt64());
+        CHECK(numList[6].getNumber().str() == "123456789012345678901234567890");
+
+        result = getResult("\x57", {gs2::makeList("-00000000000000000000000000042")});
+        REQUIRE(result.size() == 1);
+        numList = result[0].getList();
+        REQUIRE(numList.size() == 1);
+        CHECK(numList[0].getNumber() == -42);
     }
 }
 
@@ -884,6 +926,19 @@ TEST_CASE("Test 0x64 - sum / even") {
     REQUIRE(result[0].isNumber());
     CHECK(result[0].getNumber() == 10);
 
+    // Ranges are summed without building their elements
+    result = getResult("\x2f\x64", {1000000});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 500000500000);
+
+    result = getResult("\x2e\x20\x13\x34\x64", {10});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 9 + 6 + 3 + 0);
+
+    result = getResult("\x2e\x64", {0});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 0);
+
     // Trying to sum a list with a non-number should throw
     gs2::List list;
     list.add(list);
@@ -909,6 +964,14 @@ TEST_CASE("Test 0x65 - product / odd") {
     REQUIRE(result[0].isNumber());
     CHECK(result[0].getNumber() == 24);
 
+    result = getResult("\x2f\x65", {25});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber().str() == "15511210043330985984000000");
+
+    result = getResult("\x2e\x65", {25});
+    REQUIRE(result.size() == 1);
+    CHECK(result[0].getNumber() == 0);
+
     // Trying to multiply a list with a non-number should throw
     gs2::List list;
     list.add(list);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace tests {
+
+// A memory resource which counts how many bytes are allocated through it, for
+// checking how much memory lists use while it's the default
+class CountingResource: public std::pmr::memory_resource {
+    public:
+        size_t allocated = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override {
+            allocated += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+};
+
+} // namespace tests
@@ -0,0 +1,192 @@
+#include "catch2/catch.hpp"
+
+#include "counting-resource.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "input.hpp"
+#include "value.hpp"
+
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+    #include <unistd.h>
+#endif
+
+namespace {
+
+std::string toString(gs2::List::ByteView bytes) {
+    return std::string(bytes.begin(), bytes.end());
+}
+
+std::string toString(const gs2::List &list) {
+    REQUIRE(list.isBytes());
+    return toString(list.getBytes());
+}
+
+// Reads the lines of a temporary file holding the contents
+std::vector<std::string> readLines(const std::string &contents) {
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fflush(file);
+    std::rewind(file);
+
+    std::vector<std::string> lines;
+    gs2::LineReader reader{fileno(file)};
+    gs2::List::Bytes line;
+    while (reader.next(line)) {
+        lines.push_back(toString(line));
+    }
+    CHECK(reader.hasBufferedLine());
+    CHECK_FALSE(reader.next(line));
+
+    std::fclose(file);
+    return lines;
+}
+
+// Reads back the contents of a temporary file, after skipping some of it
+std::string readFile(const std::string &contents, long skip = 0) {
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fflush(file);
+    std::fseek(file, skip, SEEK_SET);
+
+    auto read = toString(gs2::readInput(fileno(file)));
+    std::fclose(file);
+    return read;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing reading input from files") {
+    CHECK(readFile("") == "");
+    CHECK(readFile("Hello, World!\n") == "Hello, World!\n");
+    CHECK(readFile("Hello, World!\n", 7) == "World!\n");
+
+    std::string big(3000000, 'x');
+    big[1234567] = '\0';
+    CHECK(readFile(big) == big);
+}
+
+#ifndef WIN32
+TEST_CASE("Testing reading input mapped from regular files") {
+    // Declared first, so that it outlives the lists it allocates for
+    tests::CountingResource counting;
+
+    std::string contents(1000000, 'x');
+    contents[4321] = 'y';
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fflush(file);
+    std::rewind(file);
+
+    auto previous = std::pmr::set_default_resource(&counting);
+    auto input = gs2::readInput(fileno(file));
+    auto allocated = counting.allocated;
+    auto position = lseek(fileno(file), 0, SEEK_CUR);
+    std::fclose(file);
+
+    // The bytes are only copied once the list is modified, and the mapping
+    // outlives the file being closed
+    auto copy = input;
+    copy.add('z');
+    std::pmr::set_default_resource(previous);
+
+    CHECK(allocated < 1000);
+    CHECK(position == static_cast<off_t>(contents.size()));
+    CHECK(toString(input) == contents);
+    CHECK(toString(copy) == contents + 'z');
+    CHECK(copy[4321].getNumber() == 'y');
+}
+
+TEST_CASE("Testing lines on input mapped from regular files") {
+    tests::CountingResource counting;
+
+    std::string line(100000, 'x');
+    std::string contents;
+    for (int i = 0; i < 10; i++) {
+        contents += line + '\n';
+    }
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fflush(file);
+    std::rewind(file);
+
+    auto input = gs2::readInput(fileno(file));
+    std::fclose(file);
+    auto mapping = input.getBytes().data();
+
+    // Popping and splitting mapped bytes leaves them where they are
+    auto popped = input;
+    CHECK(popped.pop().getNumber() == '\n');
+    auto rest = popped.splitAt(line.size());
+    REQUIRE(popped.isBytes());
+    REQUIRE(rest.isBytes());
+    CHECK(popped.getBytes().data() == mapping);
+    CHECK(rest.getBytes().data() == mapping + line.size());
+    CHECK(toString(popped) == line);
+    CHECK(toString(rest) == contents.substr(line.size(), contents.size() - line.size() - 1));
+
+    // So lines only allocates the lines themselves, and not a copy of the
+    // whole input
+    auto previous = std::pmr::set_default_resource(&counting);
+    gs2::List stack;
+    stack.add(input);
+    gs2::GS2Context gs2{stack};
+    std::vector<uint8_t> code{0x2a};
+    gs2::Block::parseBytes(code).execute(gs2);
+    std::pmr::set_default_resource(previous);
+
+    CHECK(counting.allocated < contents.size() + 10000);
+    REQUIRE(stack.size() == 1);
+    const auto &lines = stack[0].getList();
+    REQUIRE(lines.size() == 10);
+    CHECK(toString(lines[9].getList()) == line);
+    CHECK(toString(input) == contents);
+}
+#endif
+
+TEST_CASE("Testing reading input one line at a time") {
+    using Lines = std::vector<std::string>;
+
+    // There's always at least one line, as with the lines command
+    CHECK(readLines("") == Lines{""});
+    CHECK(readLines("\n") == Lines{""});
+    CHECK(readLines("abc") == Lines{"abc"});
+    CHECK(readLines("abc\n") == Lines{"abc"});
+    CHECK(readLines("abc\n\ndef") == Lines{"abc", "", "def"});
+    CHECK(readLines("abc\ndef\n\n") == Lines{"abc", "def", ""});
+
+    // Lines longer than the buffer, and lots of lines spanning buffers
+    std::string big(200000, 'x');
+    CHECK(readLines("a\n" + big + "\nb") == Lines{"a", big, "b"});
+
+    Lines many;
+    std::string contents;
+    for (int i = 0; i < 50000; i++) {
+        many.push_back(std::to_string(i));
+        contents += many.back() + '\n';
+    }
+    CHECK(readLines(contents) == many);
+}
+
+#ifndef WIN32
+TEST_CASE("Testing reading input from pipes") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+
+    std::string contents{"abc\0def\n", 8};
+    REQUIRE(write(fds[1], contents.data(), contents.size()) == 8);
+    close(fds[1]);
+
+    CHECK(toString(gs2::readInput(fds[0])) == contents);
+    close(fds[0]);
+}
+#endif
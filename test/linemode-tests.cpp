@@ -0,0 +1,88 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "gs2exception.hpp"
+#include "input.hpp"
+#include "linemode.hpp"
+#include "output.hpp"
+#include "program.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Runs a line mode program over the whole input at once, and returns what it
+// would print
+std::string runAll(const std::vector<uint8_t> &code, const std::string &input) {
+    auto program = gs2::Program::compile(gs2::Block::parseBytes(code));
+
+    gs2::List stack;
+    stack.add(gs2::List{gs2::List::Bytes(input.begin(), input.end())});
+    gs2::GS2Context gs2{stack};
+    gs2::Block{program, 0}.execute(gs2);
+
+    std::string printed;
+    for (const auto &value: stack) {
+        printed += value.str();
+    }
+    return printed;
+}
+
+// Runs a line mode program one line at a time, and returns what it printed
+std::string runStreaming(const std::vector<uint8_t> &code, const std::string &input) {
+    auto program = gs2::Program::compile(gs2::Block::parseBody(code));
+
+    auto inputFile = std::tmpfile();
+    auto outputFile = std::tmpfile();
+    REQUIRE(inputFile != nullptr);
+    REQUIRE(outputFile != nullptr);
+    std::fwrite(input.data(), 1, input.size(), inputFile);
+    std::fflush(inputFile);
+    std::rewind(inputFile);
+
+    {
+        gs2::LineReader reader{fileno(inputFile)};
+        gs2::Output output{fileno(outputFile)};
+        gs2::streamLines(gs2::Block{program, 0}, reader, output, gs2::Engine::Threaded);
+    }
+
+    std::string printed;
+    std::rewind(outputFile);
+    for (int c; (c = std::fgetc(outputFile)) != EOF;) {
+        printed += static_cast<char>(c);
+    }
+    std::fclose(inputFile);
+    std::fclose(outputFile);
+    return printed;
+}
+
+void checkSame(const std::vector<uint8_t> &code, const std::string &input) {
+    CHECK(runStreaming(code, input) == runAll(code, input));
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing streaming line mode") {
+    // Leaving the line alone
+    checkSame({0x30}, "");
+    checkSame({0x30}, "abc");
+    checkSame({0x30}, "abc\ndef\n");
+    checkSame({0x30}, "abc\n\n\ndef\n\n");
+
+    // Multiple results from each line
+    checkSame({0x30, 0x40, 0x0d}, "abc\ndef");
+
+    // Results which are numbers
+    checkSame({0x30, 0x57, 0x64}, "1 2 3\n4 5 6\n\n-7 -8 -9\n");
+
+    std::string many;
+    for (int i = 0; i < 100000; i++) {
+        many += std::to_string(i) + '\n';
+    }
+    checkSame({0x30, 0x56}, many);
+
+    CHECK_THROWS_AS(runStreaming({0x30, 0x0c}, "abc"), gs2::GS2Exception);
+}
@@ -0,0 +1,443 @@
+#include "catch2/catch.hpp"
+
+#include "counting-resource.hpp"
+
+#include "arena.hpp"
+#include "gs2exception.hpp"
+#include "utils.hpp"
+#include "value.hpp"
+
+#include <memory_resource>
+#include <string>
+
+TEST_CASE("Testing byte string lists") {
+    gs2::List list;
+    list.add('a');
+    list.add(0xff);
+    list.add(0);
+    CHECK(list.isBytes());
+    CHECK(list.size() == 3);
+    CHECK(list[1].getNumber() == 0xff);
+    CHECK(list.back().getNumber() == 0);
+
+    list.prepend('z');
+    list.concat(gs2::makeList("bc"));
+    list.reverse();
+    CHECK(list.isBytes());
+    CHECK(list.getBytes() == gs2::List::Bytes{'c', 'b', 0, 0xff, 'a', 'z'});
+
+    CHECK(list.pop().getNumber() == 'z');
+    CHECK(list.take(0).getNumber() == 'c');
+    CHECK(list.isBytes());
+
+    // Strings built from text are byte strings
+    CHECK(gs2::makeList("hello").isBytes());
+    CHECK(gs2::Value{gs2::makeList("hello")}.str() == "hello");
+}
+
+TEST_CASE("Testing promotion of byte string lists") {
+    SECTION("Adding a number which isn't a byte") {
+        auto list = gs2::makeList("ab");
+        list.add(256);
+        CHECK_FALSE(list.isBytes());
+        CHECK(list.size() == 3);
+        CHECK(list[0].getNumber() == 'a');
+        CHECK(list[2].getNumber() == 256);
+    }
+
+    SECTION("Adding a negative number") {
+        auto list = gs2::makeList("ab");
+        list.prepend(-1);
+        CHECK_FALSE(list.isBytes());
+        CHECK(list[0].getNumber() == -1);
+        CHECK(list[1].getNumber() == 'a');
+    }
+
+    SECTION("Adding a list") {
+        auto list = gs2::makeList("ab");
+        list.add(gs2::makeList("cd"));
+        CHECK_FALSE(list.isBytes());
+        CHECK(list[2].isList());
+    }
+
+    SECTION("Concatenating a general list") {
+        auto list = gs2::makeList("ab");
+        gs2::List other;
+        other.add(gs2::Block{});
+        list.concat(other);
+        CHECK_FALSE(list.isBytes());
+        CHECK(list[2].isBlock());
+    }
+}
+
+TEST_CASE("Testing byte string comparison") {
+    auto bytes = gs2::makeList("abc");
+
+    // The same elements compare equal whichever way they're stored
+    gs2::List values;
+    values.add(gs2::Block{});
+    values.pop();
+    values.add('a');
+    values.add('b');
+    values.add('c');
+    CHECK_FALSE(values.isBytes());
+
+    CHECK_FALSE(bytes != values);
+    CHECK_FALSE(values != bytes);
+    CHECK(bytes != gs2::makeList("abd"));
+}
+
+TEST_CASE("Testing that copies of a list share elements until modified") {
+    gs2::List original;
+    original.add(gs2::makeList("abc"));
+    original.add(1000);
+
+    auto copy = original;
+    CHECK(&copy[0] == &original[0]);
+    CHECK_FALSE(copy != original);
+
+    SECTION("Adding to a copy") {
+        copy.add(7);
+        CHECK(copy.size() == 3);
+        CHECK(original.size() == 2);
+        CHECK(copy[0].getList().isBytes());
+    }
+
+    SECTION("Popping from a copy") {
+        CHECK(copy.pop().getNumber() == 1000);
+        CHECK(original.size() == 2);
+        CHECK(original[1].getNumber() == 1000);
+    }
+
+    SECTION("Reversing a copy") {
+        copy.reverse();
+        CHECK(copy[0].getNumber() == 1000);
+        CHECK(original[0].isList());
+    }
+
+    SECTION("Taking from a copy") {
+        auto taken = copy.take(0);
+        CHECK(makeString(taken) == "abc");
+        CHECK(makeString(original[0]) == "abc");
+    }
+
+    SECTION("Concatenating a list to itself") {
+        original.concat(copy);
+        CHECK(original.size() == 4);
+        CHECK(original[3].getNumber() == 1000);
+        CHECK(copy.size() == 2);
+    }
+}
+
+TEST_CASE("Testing lists allocated from an arena") {
+    gs2::Arena arena;
+
+    gs2::List list;
+    for (int i = 0; i < 1000; i++) {
+        list.add(i);
+    }
+    auto copy = list;
+    copy.add(gs2::makeList("abc"));
+
+    CHECK(list.size() == 1000);
+    CHECK(copy.size() == 1001);
+    CHECK(list[999].getNumber() == 999);
+    CHECK(gs2::makeString(copy[1000]) == "abc");
+}
+
+TEST_CASE("Testing range lists") {
+    gs2::List range{gs2::List::Range{1, 1, 10}};
+    CHECK(range.isRange());
+    CHECK(range.size() == 10);
+    CHECK(range.take(3).getNumber() == 4);
+
+    SECTION("Reading elements in place") {
+        CHECK(range[0].getNumber() == 1);
+        CHECK(range.back().getNumber() == 10);
+        CHECK(range.isRange());
+        CHECK_FALSE(range != gs2::makeList("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a"));
+    }
+
+    SECTION("Popping and reversing keep the range") {
+        CHECK(range.pop().getNumber() == 10);
+        range.reverse();
+        CHECK(range.isRange());
+        CHECK(range.size() == 9);
+        CHECK(range[0].getNumber() == 9);
+        CHECK(range[8].getNumber() == 1);
+    }
+
+    SECTION("Adding fills in the elements") {
+        range.add(1000);
+        CHECK_FALSE(range.isRange());
+        CHECK(range.size() == 11);
+        CHECK(range[9].getNumber() == 10);
+        CHECK(range[10].getNumber() == 1000);
+    }
+
+    SECTION("Small ranges are filled in as byte strings") {
+        range.prepend(0);
+        CHECK(range.isBytes());
+        CHECK(range.getBytes() == gs2::List::Bytes{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    }
+
+    SECTION("Copies of a range are independent") {
+        auto copy = range;
+        copy.pop();
+        copy.add(-1);
+        CHECK(range.size() == 10);
+        CHECK(range[9].getNumber() == 10);
+        CHECK(copy[9].getNumber() == -1);
+    }
+
+    SECTION("Stepping over a range") {
+        auto stepped = gs2::stepOver(range, 3);
+        CHECK(stepped.isRange());
+        REQUIRE(stepped.size() == 4);
+        CHECK(stepped[1].getNumber() == 4);
+        CHECK(stepped[3].getNumber() == 10);
+
+        stepped = gs2::stepOver(range, -4);
+        CHECK(stepped.isRange());
+        REQUIRE(stepped.size() == 3);
+        CHECK(stepped[0].getNumber() == 10);
+        CHECK(stepped[2].getNumber() == 2);
+    }
+}
+
+TEST_CASE("Testing rope lists") {
+    gs2::List list;
+    for (int i = 0; i < 100; i++) {
+        list.add(1000 + i);
+    }
+    CHECK_FALSE(list.isRope());
+
+    // Prepending to a long list switches it to a rope
+    list.prepend(-1);
+    CHECK(list.isRope());
+    REQUIRE(list.size() == 101);
+    CHECK(list[0].getNumber() == -1);
+    CHECK(list[1].getNumber() == 1000);
+    CHECK(list.back().getNumber() == 1099);
+
+    SECTION("Building a list by prepending") {
+        for (int i = 0; i < 100000; i++) {
+            list.prepend(i);
+        }
+        REQUIRE(list.size() == 100101);
+        CHECK(list[0].getNumber() == 99999);
+        CHECK(list[99999].getNumber() == 0);
+        CHECK(list[100000].getNumber() == -1);
+        CHECK(list.pop().getNumber() == 1099);
+        CHECK(list.size() == 100100);
+    }
+
+    SECTION("Building a list by concatenating it onto others") {
+        for (int i = 0; i < 10000; i++) {
+            auto front = gs2::makeList("ab");
+            front.concat(list);
+            list = std::move(front);
+        }
+        REQUIRE(list.size() == 20101);
+        CHECK(list[20000].getNumber() == -1);
+        CHECK(gs2::makeString(list[19999]) == "b");
+        CHECK(list.back().getNumber() == 1099);
+    }
+
+    SECTION("Copies of a rope are independent") {
+        auto copy = list;
+        copy.prepend(-2);
+        copy.add(-3);
+        copy.concat(copy);
+        CHECK(list.size() == 101);
+        CHECK(list[0].getNumber() == -1);
+        REQUIRE(copy.size() == 206);
+        CHECK(copy[0].getNumber() == -2);
+        CHECK(copy[103].getNumber() == -2);
+        CHECK(copy.back().getNumber() == -3);
+    }
+
+    SECTION("Splitting a rope") {
+        auto rest = list.splitAt(41);
+        CHECK(rest.isRope());
+        REQUIRE(list.size() == 41);
+        REQUIRE(rest.size() == 60);
+        CHECK(list.back().getNumber() == 1039);
+        CHECK(rest[0].getNumber() == 1040);
+
+        list.concat(rest);
+        CHECK(list.size() == 101);
+        CHECK(list[41].getNumber() == 1040);
+    }
+
+    SECTION("Reversing a rope") {
+        list.reverse();
+        CHECK_FALSE(list.isRope());
+        CHECK(list[0].getNumber() == 1099);
+        CHECK(list.back().getNumber() == -1);
+    }
+}
+
+TEST_CASE("Testing concatenating byte strings with ropes") {
+    // Declared first, so that it outlives the lists whose nodes it allocates
+    tests::CountingResource counting;
+    const std::string text(100000, 'a');
+
+    gs2::List rope;
+    for (int i = 0; i < 100; i++) {
+        rope.add(1000 + i);
+    }
+    rope.prepend(-1);
+    REQUIRE(rope.isRope());
+
+    auto front = gs2::makeList(text);
+    auto back = gs2::makeList(text);
+
+    // The bytes should go into the rope as bytes, rather than as a Value each
+    auto previous = std::pmr::set_default_resource(&counting);
+    front.concat(rope);
+    rope.concat(back);
+    std::pmr::set_default_resource(previous);
+
+    // Both copies of the text, along with the nodes holding them
+    CHECK(counting.allocated < 4 * text.size());
+
+    CHECK(front.isRope());
+    REQUIRE(front.size() == 100101);
+    CHECK(front[0].getNumber() == 'a');
+    CHECK(front[99999].getNumber() == 'a');
+    CHECK(front[100000].getNumber() == -1);
+    CHECK(front.back().getNumber() == 1099);
+
+    REQUIRE(rope.size() == 100101);
+    CHECK(rope[0].getNumber() == -1);
+    CHECK(rope[101].getNumber() == 'a');
+    CHECK(rope.back().getNumber() == 'a');
+
+    // Adding to either end of the bytes keeps working
+    front.prepend('b');
+    rope.add(gs2::makeList("c"));
+    CHECK(front[0].getNumber() == 'b');
+    CHECK(gs2::makeString(rope.back()) == "c");
+    CHECK(gs2::makeString(rope.splitAt(100100)[1]) == "c");
+}
+
+TEST_CASE("Testing building long byte strings from the front") {
+    auto list = gs2::makeList(std::string(100, 'a'));
+
+    SECTION("Prepending bytes") {
+        for (int i = 0; i < 100000; i++) {
+            list.prepend('b');
+        }
+        CHECK(list.isRope());
+        REQUIRE(list.size() == 100100);
+        CHECK(list[0].getNumber() == 'b');
+        CHECK(list[99999].getNumber() == 'b');
+        CHECK(list[100000].getNumber() == 'a');
+        CHECK(list.back().getNumber() == 'a');
+    }
+
+    SECTION("Concatenating short strings onto the front") {
+        for (int i = 0; i < 50000; i++) {
+            auto front = gs2::makeList("bc");
+            front.concat(list);
+            list = std::move(front);
+        }
+        CHECK(list.isRope());
+        REQUIRE(list.size() == 100100);
+        CHECK(list[0].getNumber() == 'b');
+        CHECK(list[99999].getNumber() == 'c');
+        CHECK(gs2::makeString(gs2::Value{list.splitAt(100000)}) == std::string(100, 'a'));
+    }
+
+    // Short byte strings are still added to in place
+    auto shortList = gs2::makeList("bc");
+    shortList.prepend('a');
+    shortList.concat(gs2::makeList("d"));
+    CHECK(shortList.isBytes());
+    CHECK(gs2::makeString(gs2::Value{shortList}) == "abcd");
+
+    // Byte strings long enough for other lists to become ropes stay flat, so
+    // that splitting and writing them can use their bytes directly
+    auto longer = gs2::makeList(std::string(1000, 'x'));
+    longer.concat(gs2::makeList(std::string(1000, 'y')));
+    longer.prepend('w');
+    CHECK(longer.isBytes());
+    REQUIRE(longer.size() == 2001);
+    CHECK(longer[0].getNumber() == 'w');
+    CHECK(longer[1001].getNumber() == 'y');
+}
+
+TEST_CASE("Testing rope lists against a vector") {
+    // The same operations done to a rope and a vector should leave them with
+    // the same elements
+    std::vector<int> expected;
+    gs2::List list;
+    unsigned seed = 12345;
+    auto random = [&seed] (unsigned limit) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % limit;
+    };
+
+    for (int i = 0; i < 5000; i++) {
+        switch (random(5)) {
+            case 0:
+                list.prepend(i);
+                expected.insert(expected.begin(), i);
+                break;
+
+            case 1:
+                list.add(i);
+                expected.push_back(i);
+                break;
+
+            case 2: {
+                auto copy = list;
+                list.concat(copy);
+                auto old = expected;
+                expected.insert(expected.end(), old.begin(), old.end());
+                break;
+            }
+
+            case 3: {
+                auto index = random(static_cast<unsigned>(expected.size()) + 1);
+                list.splitAt(index);
+                expected.resize(std::min<size_t>(index, expected.size()));
+                break;
+            }
+
+            case 4:
+                if (!expected.empty()) {
+                    CHECK(list.pop().getNumber() == expected.back());
+                    expected.pop_back();
+                }
+                break;
+        }
+
+        REQUIRE(list.size() == expected.size());
+    }
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        REQUIRE(list[i].getNumber() == expected[i]);
+    }
+}
+
+TEST_CASE("Testing splitting lists") {
+    auto bytes = gs2::makeList("hello");
+    CHECK(gs2::makeString(bytes.splitAt(2)) == "llo");
+    CHECK(gs2::makeString(bytes) == "he");
+
+    gs2::List range{gs2::List::Range{0, 2, 5}};
+    auto rest = range.splitAt(3);
+    CHECK(range.isRange());
+    CHECK(rest.isRange());
+    CHECK(range.back().getNumber() == 4);
+    CHECK(rest[0].getNumber() == 6);
+
+    gs2::List values;
+    values.add(gs2::Block{});
+    values.add(1000);
+    CHECK(values.splitAt(5).empty());
+    CHECK(values.splitAt(0).size() == 2);
+    CHECK(values.empty());
+}
@@ -0,0 +1,96 @@
+#include "catch2/catch.hpp"
+
+#include "number.hpp"
+
+#include <limits>
+
+namespace {
+
+constexpr auto MAX = std::numeric_limits<int64_t>::max();
+constexpr auto MIN = std::numeric_limits<int64_t>::min();
+
+} // anonymous namespace
+
+TEST_CASE("Testing small number arithmetic") {
+    gs2::Number x = 20;
+    x += 22;
+    CHECK(x == 42);
+    x *= -3;
+    CHECK(x == -126);
+    x %= 10;
+    CHECK(x == -6);
+    x /= 4;
+    CHECK(x == -1);
+    CHECK(x.fitsInt64());
+}
+
+TEST_CASE("Testing promotion on overflow") {
+    SECTION("Addition") {
+        gs2::Number x = MAX;
+        x += 1;
+        CHECK_FALSE(x.fitsInt64());
+        CHECK(x.str() == "9223372036854775808");
+        CHECK(x > MAX);
+
+        // Coming back into range demotes the number again
+        x -= 1;
+        CHECK(x.fitsInt64());
+        CHECK(x == MAX);
+    }
+
+    SECTION("Multiplication") {
+        gs2::Number x = int64_t{1} << 62;
+        x *= 4;
+        CHECK(x.str() == "18446744073709551616");
+        x *= x;
+        CHECK(x.str() == "340282366920938463463374607431768211456");
+    }
+
+    SECTION("Negation") {
+        gs2::Number x = MIN;
+        x *= -1;
+        CHECK_FALSE(x.fitsInt64());
+        CHECK(x.str() == "9223372036854775808");
+    }
+
+    SECTION("Division") {
+        gs2::Number x = MIN;
+        x /= -1;
+        CHECK(x.str() == "9223372036854775808");
+
+        gs2::Number y = MIN;
+        y %= -1;
+        CHECK(y == 0);
+    }
+
+    SECTION("Unsigned numbers too big for an int64_t") {
+        gs2::Number x = std::numeric_limits<uint64_t>::max();
+        CHECK(x.str() == "18446744073709551615");
+        CHECK(x > MAX);
+    }
+}
+
+TEST_CASE("Testing numbers from strings") {
+    CHECK(gs2::Number{"-42"} == -42);
+    CHECK(gs2::Number{"-42"}.fitsInt64());
+
+    gs2::Number big{"123456789012345678901234567890"};
+    CHECK_FALSE(big.fitsInt64());
+    CHECK(big.str() == "123456789012345678901234567890");
+    CHECK(big % 1000 == 890);
+}
+
+TEST_CASE("Testing conversions") {
+    CHECK(static_cast<char>(gs2::Number{'A'}) == 'A');
+    CHECK(static_cast<bool>(gs2::Number{0}) == false);
+    CHECK(static_cast<bool>(gs2::Number{"100000000000000000000"}) == true);
+
+    // Numbers which don't fit saturate, whether they're stored inline or not
+    CHECK(static_cast<char>(gs2::Number{300}) == 127);
+    CHECK(static_cast<char>(gs2::Number{-300}) == -128);
+    CHECK(static_cast<char>(gs2::Number{"100000000000000000000"}) == 127);
+    CHECK(static_cast<char>(gs2::Number{"-100000000000000000000"}) == -128);
+    CHECK(static_cast<int>(gs2::Number{MAX}) == std::numeric_limits<int>::max());
+    CHECK(static_cast<int>(gs2::Number{MIN}) == std::numeric_limits<int>::min());
+    CHECK(static_cast<uint64_t>(gs2::Number{MAX}) == static_cast<uint64_t>(MAX));
+}
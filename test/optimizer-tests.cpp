@@ -0,0 +1,108 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "program.hpp"
+#include "utils.hpp"
+
+namespace {
+
+std::shared_ptr<const gs2::Program> optimizeProgram(const std::string &code, int level,
+                                                     gs2::OptimizationReport &report)
+{
+    std::vector<uint8_t> codeBytes{code.begin(), code.end()};
+    return gs2::Program::compile(gs2::Block::parseBytes(codeBytes), level, &report);
+}
+
+std::vector<gs2::Op> rootOps(const gs2::Program &program) {
+    std::vector<gs2::Op> ops;
+    for (auto i = program.getBlockStart(0); program.getCode()[i].op != gs2::Op::Return; i++) {
+        ops.push_back(program.getCode()[i].op);
+    }
+    return ops;
+}
+
+gs2::List run(const gs2::Program &program) {
+    gs2::List stack;
+    stack.add(gs2::makeList("1 2 3"));
+
+    gs2::GS2Context gs2{stack};
+    program.execute(gs2);
+    return stack;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing constant folding") {
+    gs2::OptimizationReport report;
+
+    // 10 100 * 3 + 7 %
+    auto program = optimizeProgram("\x1a\x1b\x32\x13\x30\x17\x34", 1, report);
+    REQUIRE(rootOps(*program) == std::vector<gs2::Op>{gs2::Op::PushNumber});
+    CHECK(program->getCode()[0].immediate == 1003 % 7);
+    CHECK(report.foldedConstants == 3);
+
+    // Modulo by zero has to stay an error at runtime
+    report = {};
+    program = optimizeProgram("\x1a\x10\x34", 1, report);
+    CHECK(rootOps(*program).size() == 3);
+    CHECK(report.foldedConstants == 0);
+
+    // Results that don't fit in an immediate are left alone
+    report = {};
+    program = optimizeProgram("\x03\xff\xff\xff\x7f\x03\xff\xff\xff\x7f\x32"
+                              "\x03\xff\xff\xff\x7f\x32", 1, report);
+    CHECK(report.foldedConstants == 1);
+    CHECK(rootOps(*program).size() == 3);
+}
+
+TEST_CASE("Testing push-pop removal") {
+    gs2::OptimizationReport report;
+
+    auto program = optimizeProgram("\x11\x50\x04" "a\x07" "b\x05\x50\x08\x09\x50", 1, report);
+    REQUIRE(rootOps(*program) == std::vector<gs2::Op>{gs2::Op::PushConstants});
+    CHECK(program->getCode()[0].immediate == 1);
+    CHECK(report.removedPushPops == 3);
+
+    // dup-pop is only removed at level 2
+    report = {};
+    program = optimizeProgram("\x40\x50", 1, report);
+    CHECK(rootOps(*program).size() == 2);
+
+    program = optimizeProgram("\x40\x50", 2, report);
+    CHECK(rootOps(*program).empty());
+    CHECK(report.removedDupPops == 1);
+}
+
+TEST_CASE("Testing block inlining") {
+    gs2::OptimizationReport report;
+
+    // 1 {2 +} eval => 3
+    auto program = optimizeProgram("\x11\x08\x12\x30\x09\x20", 1, report);
+    REQUIRE(rootOps(*program) == std::vector<gs2::Op>{gs2::Op::PushNumber});
+    CHECK(program->getCode()[0].immediate == 3);
+    CHECK(report.inlinedBlocks == 1);
+    CHECK(report.foldedConstants == 1);
+
+    // Nested blocks get inlined all the way down
+    report = {};
+    program = optimizeProgram("\x08\x08\x13\x09\x20\x09\x20", 1, report);
+    CHECK(rootOps(*program) == std::vector<gs2::Op>{gs2::Op::PushNumber});
+    CHECK(report.inlinedBlocks == 2);
+}
+
+TEST_CASE("Testing that optimized programs give the same results") {
+    std::vector<std::string> programs = {
+        "\x57\x08\x1a\x1b\x32\x30\x09\x34",
+        "\x11\x12\x50\x40\x50\x08\x13\x2f\x08\x30\x09\x32\x09\x20",
+        "\x04" "a\x07" "bc\x05\x50\x30\x0a\x30\x08\x09\x50",
+        "\x08\x11\x09\x08\x12\x09\x30\x20",
+    };
+
+    for (const auto &code: programs) {
+        gs2::OptimizationReport report;
+        auto expected = run(*optimizeProgram(code, 0, report));
+        CHECK_FALSE(expected != run(*optimizeProgram(code, 1, report)));
+        CHECK_FALSE(expected != run(*optimizeProgram(code, 2, report)));
+    }
+}
@@ -0,0 +1,109 @@
+#include "catch2/catch.hpp"
+
+#include "counting-resource.hpp"
+
+#include "gs2exception.hpp"
+#include "output.hpp"
+#include "utils.hpp"
+#include "value.hpp"
+
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+
+namespace {
+
+// Writes the values to a temporary file, and reads back what was written
+std::string writeValues(const std::vector<gs2::Value> &values) {
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    {
+        gs2::Output output{fileno(file)};
+        for (const auto &value: values) {
+            output.write(value);
+        }
+    }
+
+    std::string written;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+        written += static_cast<char>(c);
+    }
+    std::fclose(file);
+
+    return written;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing writing values") {
+    CHECK(writeValues({}) == "");
+    CHECK(writeValues({-1234}) == "-1234");
+    CHECK(writeValues({gs2::Value::IntType{"123456789012345678901234567890"}}) == "123456789012345678901234567890");
+    CHECK(writeValues({gs2::makeList("Hello, "), gs2::makeList("World!")}) == "Hello, World!");
+
+    // Numbers inside of lists are written as characters
+    gs2::List nested;
+    nested.add('a');
+    nested.add(gs2::makeList("bc"));
+    nested.add(gs2::List{gs2::List::Range{'d', 1, 3}});
+    CHECK(writeValues({nested, 42}) == "abcdef42");
+
+    // Characters out of range saturate, however the number is stored
+    gs2::List outOfRange;
+    outOfRange.add(300);
+    outOfRange.add(-300);
+    outOfRange.add(gs2::Value::IntType{"1180591620717411303424"});
+    outOfRange.add(gs2::List{gs2::List::Range{254, 1, 3}});
+    CHECK(writeValues({outOfRange}) == "\x7f\x80\x7f\x7f\x7f\x7f");
+    CHECK(gs2::Value{outOfRange}.str() == "\x7f\x80\x7f\x7f\x7f\x7f");
+
+    // Output bigger than the buffer is written out in full
+    std::string big(3000000, 'x');
+    big[1234567] = 'y';
+    CHECK(writeValues({gs2::makeList("<"), gs2::makeList(big), gs2::makeList(">")}) == "<" + big + ">");
+
+    gs2::List lots;
+    for (int i = 0; i < 2000000; i++) {
+        lots.add(gs2::makeList("z"));
+    }
+    CHECK(writeValues({lots}) == std::string(2000000, 'z'));
+}
+
+TEST_CASE("Testing writing ranges") {
+    // The numbers are worked out as they're written, without filling in the
+    // range's elements, which would be allocated from the same resource as
+    // its storage
+    tests::CountingResource counting;
+    auto previous = std::pmr::set_default_resource(&counting);
+    gs2::Value range{gs2::List{gs2::List::Range{'a', 1, 26}}};
+    auto allocated = counting.allocated;
+    auto written = writeValues({range});
+    auto shown = range.str();
+    std::pmr::set_default_resource(previous);
+
+    CHECK(counting.allocated == allocated);
+    CHECK(written == "abcdefghijklmnopqrstuvwxyz");
+    CHECK(shown == "abcdefghijklmnopqrstuvwxyz");
+    CHECK(range.getList().isRange());
+}
+
+TEST_CASE("Testing writing blocks") {
+    CHECK_THROWS_AS(writeValues({gs2::Block{}}), gs2::GS2Exception);
+
+    // Nothing is written for a list containing a block
+    gs2::List list;
+    list.add(gs2::makeList("abc"));
+    list.add(gs2::Block{});
+
+    auto file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    {
+        gs2::Output output{fileno(file)};
+        output.write(gs2::makeList("ok"));
+        CHECK_THROWS_AS(output.write(list), gs2::GS2Exception);
+    }
+    CHECK(std::ftell(file) == 2);
+    std::fclose(file);
+}
@@ -0,0 +1,224 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "gs2exception.hpp"
+#include "parallel.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+gs2::Block parse(const std::string &code) {
+    std::vector<uint8_t> codeBytes{code.begin(), code.end()};
+    return gs2::Block::parseBytes(codeBytes);
+}
+
+bool isPure(const std::string &code) {
+    return gs2::isPureBlock(parse(code));
+}
+
+gs2::List runMap(const std::string &body, const gs2::List &list, size_t threads, gs2::Engine engine) {
+    auto block = parse("\xfe" + body);
+
+    gs2::List stack;
+    stack.add(list);
+    gs2::GS2Context gs2{stack};
+    gs2.setEngine(engine);
+    gs2.setThreads(threads);
+    block.execute(gs2);
+
+    REQUIRE(stack.size() == 1);
+    REQUIRE(stack[0].isList());
+    return stack[0].getList();
+}
+
+void checkSameMap(const std::string &body, const gs2::List &list) {
+    for (auto engine: {gs2::Engine::TreeWalker, gs2::Engine::Switch, gs2::Engine::Threaded}) {
+        auto serial = runMap(body, list, 1, engine);
+        auto parallel = runMap(body, list, 8, engine);
+        CHECK_FALSE(serial != parallel);
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing block purity") {
+    CHECK(isPure(""));
+    CHECK(isPure("\x40\x30"));
+    CHECK(isPure("\x52\x0d\x30"));
+    CHECK(isPure("\x50"));
+    CHECK(isPure("\x04" "ab\x07" "cd\x05\x30\x30"));
+    CHECK(isPure("\x12\x13\x32\x32"));
+
+    // Looking below the element it was given
+    CHECK_FALSE(isPure("\x30"));
+    CHECK_FALSE(isPure("\x41"));
+    CHECK_FALSE(isPure("\x50\x50"));
+    CHECK_FALSE(isPure("\x04" "ab\x07" "cd\x05\x30\x30\x30"));
+
+    // Using the counter, or blocks
+    CHECK_FALSE(isPure("\xb2"));
+    CHECK_FALSE(isPure("\x0c"));
+    CHECK_FALSE(isPure("\x08\x09"));
+    CHECK_FALSE(isPure("\xfe\x40"));
+}
+
+TEST_CASE("Testing parallelFor") {
+    std::vector<std::atomic<int>> calls(10000);
+    gs2::parallelFor(calls.size(), 8, [&] (size_t i) {
+        calls[i]++;
+    });
+    for (auto &count: calls) {
+        CHECK(count == 1);
+    }
+
+    // The exception for the first index which fails is the one thrown
+    auto failing = [] (size_t i) {
+        if (i % 1000 == 777) {
+            throw std::runtime_error{std::to_string(i)};
+        }
+    };
+    CHECK_THROWS_WITH(gs2::parallelFor(10000, 8, failing), "777");
+
+    CHECK_NOTHROW(gs2::parallelFor(0, 8, failing));
+}
+
+TEST_CASE("Testing parallel map") {
+    gs2::List numbers;
+    gs2::List strings;
+    for (int i = 0; i < 1000; i++) {
+        numbers.add(i * 7919);
+        strings.add(gs2::makeList("line " + std::to_string(i)));
+    }
+
+    checkSameMap("\x40\x30", numbers);
+    checkSameMap("\x40\x32\x52", numbers);
+    checkSameMap("\x52\x0d\x30", strings);
+    checkSameMap("\x56\x40", strings);
+    checkSameMap("\x50", strings);
+    checkSameMap("\x2f\x64", gs2::List{gs2::List::Range{0, 1, 500}});
+
+    // Errors are the same as running the elements in order
+    strings.add(gs2::makeList("no number"));
+    CHECK_THROWS_AS(runMap("\x56", strings, 8, gs2::Engine::Threaded), gs2::GS2Exception);
+
+    // Lists holding blocks are mapped in order, since the block could run them
+    gs2::List blocks;
+    for (int i = 0; i < 100; i++) {
+        blocks.add(gs2::Block{});
+    }
+    CHECK(runMap("\x20", blocks, 8, gs2::Engine::Threaded).size() == 0);
+}
+
+TEST_CASE("Testing parallel map over elements which share storage") {
+    // Each pair of elements shares its storage, and its rope's nodes for the
+    // long lists, so a worker can find that it's become the only owner once
+    // another worker is done with the other element of the pair
+    gs2::List texts;
+    gs2::List valueLists;
+    for (int i = 0; i < 500; i++) {
+        auto text = gs2::makeList("line " + std::to_string(i));
+        texts.add(text);
+        texts.add(text);
+
+        gs2::List values;
+        for (int j = 0; j < 100; j++) {
+            values.add(1000 + j);
+        }
+        values.prepend(i);
+        valueLists.add(values);
+        valueLists.add(values);
+    }
+
+    checkSameMap("\x40\x30", texts);
+    checkSameMap("\x40\x30", valueLists);
+    checkSameMap("\x40\x30\x40\x30", valueLists);
+
+    auto doubled = runMap("\x40\x30", valueLists, 8, gs2::Engine::Threaded);
+    REQUIRE(doubled.size() == 1000);
+    CHECK(doubled[999].getList().size() == 202);
+    CHECK(doubled[999].getList()[101].getNumber() == 499);
+}
+
+namespace {
+
+gs2::Value runWithThreads(const std::string &code, const gs2::List &list, size_t threads) {
+    auto block = parse(code);
+
+    gs2::List stack;
+    stack.add(list);
+    gs2::GS2Context gs2{stack};
+    gs2.setThreads(threads);
+    block.execute(gs2);
+
+    REQUIRE(stack.size() == 1);
+    return stack[0];
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing tree reductions") {
+    gs2::List numbers;
+    gs2::Value::IntType sum = 0;
+    gs2::Value::IntType product = 1;
+    for (int i = 1; i <= 10000; i++) {
+        numbers.add(i * 37);
+        sum += i * 37;
+        product *= i * 37;
+    }
+
+    for (size_t threads: {1, 8}) {
+        CHECK(gs2::sumList(numbers, threads) == sum);
+        CHECK(gs2::productList(numbers, threads) == product);
+
+        // Folding with catenate or multiply gives the same results
+        auto folded = runWithThreads("\x08\x30\x09\x32", numbers, threads);
+        REQUIRE(folded.isNumber());
+        CHECK(folded.getNumber() == sum);
+
+        folded = runWithThreads("\x08\x32\x09\x32", numbers, threads);
+        REQUIRE(folded.isNumber());
+        CHECK(folded.getNumber() == product);
+    }
+
+    // Ranges are multiplied without filling them in, unless they hit zero
+    gs2::Value::IntType factorial = 1;
+    for (int i = 1; i <= 3000; i++) {
+        factorial *= i;
+    }
+    CHECK(gs2::productList(gs2::List{gs2::List::Range{1, 1, 3000}}) == factorial);
+    CHECK(gs2::productList(gs2::List{gs2::List::Range{-9, 3, 3000}}) == 0);
+    CHECK(gs2::productList(gs2::List{gs2::List::Range{-10, 3, 3000}}) != 0);
+    CHECK(gs2::productList(gs2::List{}) == 1);
+    CHECK(gs2::sumList(gs2::List{}) == 0);
+
+    // Lists are concatenated in order
+    gs2::List strings;
+    std::string expected;
+    for (int i = 0; i < 5000; i++) {
+        auto string = std::to_string(i);
+        strings.add(gs2::makeList(string));
+        expected += string;
+    }
+    auto joined = runWithThreads("\x08\x30\x09\x32", strings, 8);
+    REQUIRE(joined.isList());
+    CHECK_FALSE(joined.getList() != gs2::makeList(expected));
+
+    // Which isn't the case when numbers and lists are mixed
+    gs2::List mixed;
+    mixed.add(1);
+    mixed.add(2);
+    mixed.add(gs2::makeList("ab"));
+    auto catenated = runWithThreads("\x08\x30\x09\x32", mixed, 8);
+    REQUIRE(catenated.isList());
+    CHECK(catenated.getList().size() == 3);
+    CHECK(catenated.getList()[0].getNumber() == 3);
+
+    numbers.add(gs2::makeList("x"));
+    CHECK_THROWS_AS(gs2::sumList(numbers, 8), gs2::GS2Exception);
+}
@@ -0,0 +1,94 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "profiler.hpp"
+
+#include <sstream>
+
+namespace {
+
+gs2::List runProfiled(const std::string &code, gs2::Engine engine, gs2::Profiler &profiler,
+                      size_t threads = 1)
+{
+    std::vector<uint8_t> codeBytes{code.begin(), code.end()};
+    auto block = gs2::Block::parseBytes(codeBytes);
+
+    gs2::List stack;
+    gs2::GS2Context gs2{stack};
+    gs2.setEngine(engine);
+    gs2.setThreads(threads);
+    gs2.setProfiler(&profiler);
+    block.execute(gs2);
+    return stack;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Testing profiling commands") {
+    auto engine = GENERATE(gs2::Engine::TreeWalker, gs2::Engine::Switch, gs2::Engine::Threaded);
+
+    // Doubles each of 1 to 10 and then sums them
+    gs2::Profiler profiler;
+    auto stack = runProfiled("\x1a\x2f\x08\x40\x30\x09\x34\x64", engine, profiler);
+
+    REQUIRE(stack.size() == 1);
+    CHECK_FALSE(stack[0] != gs2::Value{110});
+
+    CHECK(profiler.getCommand(0x1a).count == 1);
+    CHECK(profiler.getCommand(0x2f).count == 1);
+    CHECK(profiler.getCommand(0x08).count == 1);
+    CHECK(profiler.getCommand(0x34).count == 1);
+    CHECK(profiler.getCommand(0x40).count == 10);
+    CHECK(profiler.getCommand(0x30).count == 10);
+    CHECK(profiler.getCommand(0x64).count == 1);
+    CHECK(profiler.getCommand(0x32).count == 0);
+
+    CHECK(profiler.getHelper("do_map").count == 1);
+    CHECK(profiler.getHelper("fold").count == 0);
+}
+
+TEST_CASE("Testing profiling maps which could run on several threads") {
+    auto engine = GENERATE(gs2::Engine::TreeWalker, gs2::Engine::Switch, gs2::Engine::Threaded);
+
+    // Doubles each of 1 to 200 and then sums them, which is long enough to
+    // be split between threads if it weren't being profiled
+    gs2::Profiler profiler;
+    auto stack = runProfiled("\x01\xc8\x2f\x08\x40\x30\x09\x34\x64", engine, profiler, 4);
+
+    REQUIRE(stack.size() == 1);
+    CHECK_FALSE(stack[0] != gs2::Value{40200});
+
+    CHECK(profiler.getCommand(0x40).count == 200);
+    CHECK(profiler.getCommand(0x30).count == 200);
+    CHECK(profiler.getHelper("do_map").count == 1);
+}
+
+TEST_CASE("Testing profile reports") {
+    gs2::Profiler profiler;
+    profiler.addCommand(0x34, std::chrono::milliseconds{3});
+    profiler.addCommand(0x34, std::chrono::milliseconds{1});
+    profiler.addCommand(0x40, std::chrono::milliseconds{12});
+    profiler.addHelper("do_map", std::chrono::milliseconds{2});
+    profiler.addHelper("do_map", std::chrono::milliseconds{2}, false);
+
+    CHECK(profiler.getCommand(0x34).count == 2);
+    CHECK(profiler.getHelper("do_map").count == 1);
+    CHECK(profiler.getHelper("do_map").time == std::chrono::milliseconds{4});
+
+    std::ostringstream out;
+    profiler.report(out);
+    auto report = out.str();
+
+    // The slowest command comes first, and commands which never ran are left
+    // out
+    auto dup = report.find("0x40 dup");
+    auto map = report.find("0x34 mod / step / clean-split / map");
+    REQUIRE(dup != std::string::npos);
+    REQUIRE(map != std::string::npos);
+    CHECK(dup < map);
+    CHECK(report.find("0x30") == std::string::npos);
+
+    CHECK(report.find("75.0%") != std::string::npos);
+    CHECK(report.find("do_map") != std::string::npos);
+}
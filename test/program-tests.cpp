@@ -0,0 +1,223 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "command.hpp"
+#include "gs2context.hpp"
+#include "gs2exception.hpp"
+#include "program.hpp"
+#include "utils.hpp"
+
+std::shared_ptr<const gs2::Program> compileProgram(const std::string &code) {
+    std::vector<uint8_t> codeBytes{code.begin(), code.end()};
+    return gs2::Program::compile(gs2::Block::parseBytes(codeBytes));
+}
+
+TEST_CASE("Testing number decoding") {
+    auto program = compileProgram({"\x01\xee\x02\xd6\xff\x03\x13\x6d\xae\x37\x1c\x00", 12});
+    auto &code = program->getCode();
+
+    // The nop shouldn't be compiled at all
+    REQUIRE(code.size() == 5);
+
+    CHECK(code[0].op == gs2::Op::PushNumber);
+    CHECK(code[0].immediate == 0xee);
+    CHECK(code[1].op == gs2::Op::PushNumber);
+    CHECK(code[1].immediate == -42);
+    CHECK(code[2].op == gs2::Op::PushNumber);
+    CHECK(code[2].immediate == 0x37ae6d13);
+    CHECK(code[3].op == gs2::Op::PushNumber);
+    CHECK(code[3].immediate == 1000);
+    CHECK(code[4].op == gs2::Op::Return);
+}
+
+void checkString(const gs2::Value &value, const std::string &expected) {
+    REQUIRE(value.isList());
+    CHECK_FALSE(value.getList() != gs2::makeList(expected));
+}
+
+TEST_CASE("Testing the constant pool") {
+    auto program = compileProgram("\x04" "ab\x07" "c\x05\x04" "de\x06\x07z\x04" "f\x9b\x0a\x86");
+    auto &code = program->getCode();
+
+    REQUIRE(code.size() == 7);
+
+    // Each string of a regular string command is its own constant
+    REQUIRE(code[0].op == gs2::Op::PushConstants);
+    REQUIRE(code[0].immediate == 2);
+    checkString(program->getConstant(code[0].operand), "ab");
+    checkString(program->getConstant(code[0].operand + 1), "c");
+
+    // While an array string is a single constant
+    REQUIRE(code[1].op == gs2::Op::PushConstants);
+    REQUIRE(code[1].immediate == 1);
+    auto &array = program->getConstant(code[1].operand);
+    REQUIRE(array.isList());
+    REQUIRE(array.getList().size() == 1);
+    checkString(array.getList()[0], "de");
+
+    REQUIRE(code[2].op == gs2::Op::PushConstants);
+    REQUIRE(code[2].immediate == 1);
+    checkString(program->getConstant(code[2].operand), "z");
+
+    // Unsupported string ends are only an error once executed
+    CHECK(code[3].op == gs2::Op::BadStringEnd);
+    CHECK(code[3].byte == 0x9b);
+
+    // Commands which always push the same value are constants too
+    REQUIRE(code[4].op == gs2::Op::PushConstants);
+    checkString(program->getConstant(code[4].operand), "\n");
+    REQUIRE(code[5].op == gs2::Op::PushConstants);
+    checkString(program->getConstant(code[5].operand), "0123456789");
+}
+
+TEST_CASE("Testing that constants aren't modified") {
+    auto program = compileProgram("\x04" "abc\x05\x20");
+
+    gs2::List stack;
+    gs2::GS2Context gs2{stack};
+    program->execute(gs2);
+    program->execute(gs2);
+
+    // Reversing a pushed string shouldn't affect later pushes of it
+    REQUIRE(stack.size() == 2);
+    checkString(stack[0], "cba");
+    checkString(stack[1], "cba");
+    checkString(program->getConstant(0), "abc");
+}
+
+TEST_CASE("Testing nested block layout") {
+    auto program = compileProgram("\x08\x2a\x08\x2b\x09\x09\x30");
+    auto &code = program->getCode();
+
+    REQUIRE(program->getBlockCount() == 3);
+
+    // The outer block comes first, and refers to its nested block by index
+    auto outer = program->getBlockStart(0);
+    REQUIRE(code[outer].op == gs2::Op::PushBlock);
+    auto middleIndex = code[outer].operand;
+    CHECK(code[outer + 1].op == gs2::Op::Call);
+    CHECK(code[outer + 1].byte == 0x30);
+    CHECK(code[outer + 2].op == gs2::Op::Return);
+
+    auto middle = program->getBlockStart(middleIndex);
+    CHECK(code[middle].op == gs2::Op::Call);
+    CHECK(code[middle].byte == 0x2a);
+    REQUIRE(code[middle + 1].op == gs2::Op::PushBlock);
+    CHECK(code[middle + 2].op == gs2::Op::Return);
+
+    auto inner = program->getBlockStart(code[middle + 1].operand);
+    CHECK(code[inner].op == gs2::Op::Call);
+    CHECK(code[inner].byte == 0x2b);
+    CHECK(code[inner + 1].op == gs2::Op::Return);
+
+    // Each compiled block still knows its source commands
+    auto &middleSource = program->getSource(middleIndex).getCommands();
+    REQUIRE(middleSource.size() == 3);
+    REQUIRE(middleSource[0].isBytes());
+    CHECK(middleSource[0].getBytes() == std::vector<uint8_t>{0x2a});
+    CHECK(middleSource[1].isBlock());
+}
+
+TEST_CASE("Testing instruction source offsets") {
+    auto program = compileProgram("\x01\x05\x08\x40\x09\xfe\x30");
+    auto &code = program->getCode();
+
+    // The nop closing the first block isn't compiled
+    REQUIRE(code.size() >= 5);
+    CHECK(code[0].offset == 0);
+    CHECK(code[1].op == gs2::Op::PushBlock);
+    CHECK(code[1].offset == 2);
+    CHECK(code[2].op == gs2::Op::PushBlock);
+    CHECK(code[2].offset == 5);
+    CHECK(code[3].byte == 0x34);
+    CHECK(code[3].offset == 5);
+
+    auto inner = program->getBlockStart(code[1].operand);
+    CHECK(code[inner].offset == 3);
+
+    // Folded constants are placed where the first of them was
+    std::vector<uint8_t> folded{0x40, 0x1a, 0x1b, 0x30};
+    auto optimized = gs2::Program::compile(gs2::Block::parseBytes(folded), 1);
+    REQUIRE(optimized->getCode().size() == 3);
+    CHECK(optimized->getCode()[1].immediate == 110);
+    CHECK(optimized->getCode()[1].offset == 1);
+}
+
+TEST_CASE("Testing unknown commands") {
+    auto program = compileProgram("\xff\x09\xfd");
+    auto &code = program->getCode();
+
+    // Filter isn't supported yet, so both it and 0xfd are unknown commands
+    REQUIRE(code.size() == 5);
+    CHECK(code[1].op == gs2::Op::BadCommand);
+    CHECK(code[1].byte == 0x35);
+    CHECK(code[2].op == gs2::Op::BadCommand);
+    CHECK(code[2].byte == 0xfd);
+}
+
+gs2::List runWithEngine(const std::string &code, gs2::Engine engine) {
+    std::vector<uint8_t> codeBytes{code.begin(), code.end()};
+    auto block = gs2::Block::parseBytes(codeBytes);
+
+    gs2::List stack;
+    stack.add(gs2::makeList("12 3\n-4 5\n"));
+
+    gs2::GS2Context gs2{stack};
+    gs2.setEngine(engine);
+    block.execute(gs2);
+    return stack;
+}
+
+TEST_CASE("Testing that every engine gives the same results") {
+    std::vector<std::string> programs = {
+        "\x2a\x08\x57\x64\x09\x34",
+        "\x30\x57\x08\x2a\x09\x34",
+        "\x1a\x2f\x08\x30\x09\x32\x08\x11\x09\x13\x32",
+        "\x04" "ab\x07" "cd\x05\x04" "ef\x06\x07" "g\x30\x30",
+        "\x08\x08\x13\x2f\x09\x20\x09\x20\x0c\x30\x20\xb2\xb2",
+    };
+
+    for (const auto &program: programs) {
+        auto expected = runWithEngine(program, gs2::Engine::TreeWalker);
+        CHECK_FALSE(expected != runWithEngine(program, gs2::Engine::Switch));
+        CHECK_FALSE(expected != runWithEngine(program, gs2::Engine::Threaded));
+    }
+
+    for (auto engine: {gs2::Engine::TreeWalker, gs2::Engine::Switch, gs2::Engine::Threaded}) {
+        CHECK_THROWS_AS(runWithEngine("\xfd", engine), gs2::GS2Exception);
+        CHECK_THROWS_AS(runWithEngine("\x04" "a\x9c", engine), gs2::GS2Exception);
+    }
+}
+
+TEST_CASE("Testing deeply nested evaluation") {
+    // Each level pushes a block and evaluates it, which doesn't use up any
+    // native stack in the compiled engines
+    const size_t depth = 10000;
+    std::string code = std::string(depth, '\x08') + "\x11";
+    for (size_t i = 0; i < depth; i++) {
+        code += "\x09\x20";
+    }
+
+    for (auto engine: {gs2::Engine::Switch, gs2::Engine::Threaded}) {
+        auto result = runWithEngine(code, engine);
+        REQUIRE(result.size() == 2);
+        REQUIRE(result[1].isNumber());
+        CHECK(result[1].getNumber() == 1);
+    }
+}
+
+TEST_CASE("Testing that a failed run leaves the context usable") {
+    std::vector<uint8_t> failing{0x08, 0x1a, 0x2f, 0x08, 0xfd, 0x09, 0x34, 0x09, 0x20};
+    std::vector<uint8_t> working{0x08, 0x13, 0x2f, 0x08, 0x2a, 0x09, 0x34, 0x09, 0x20, 0x64};
+
+    gs2::List stack;
+    gs2::GS2Context gs2{stack};
+
+    CHECK_THROWS_AS(gs2::Block::parseBytes(failing).execute(gs2), gs2::GS2Exception);
+    CHECK_FALSE(gs2.getInterpreter().isRunning());
+
+    stack.clear();
+    gs2::Block::parseBytes(working).execute(gs2);
+    REQUIRE(stack.size() == 1);
+    CHECK(stack[0].getNumber() == 12);
+}
@@ -0,0 +1,82 @@
+#include "catch2/catch.hpp"
+
+#include "block.hpp"
+#include "gs2context.hpp"
+#include "sampler.hpp"
+
+#include <sstream>
+
+#ifndef WIN32
+
+TEST_CASE("Testing recording samples") {
+    // Long enough that the timer never fires during the test
+    gs2::Sampler sampler{std::chrono::seconds{10}};
+
+    sampler.record({{0x34, 3, nullptr}, {0, 0, "do_map"}, {0x40, 1, nullptr}});
+    sampler.record({{0x34, 3, nullptr}, {0, 0, "do_map"}, {0x40, 1, nullptr}});
+    sampler.record({{0x34, 3, nullptr}, {0, 0, "do_map"}});
+    sampler.record({{0x64, 4, nullptr}});
+
+    CHECK(sampler.getTotal() == 4);
+    CHECK_FALSE(gs2::Sampler::isDue());
+
+    std::ostringstream folded;
+    sampler.writeFolded(folded);
+    CHECK(folded.str() ==
+          "mod / step / clean-split / map @3;do_map 1\n"
+          "mod / step / clean-split / map @3;do_map;dup @1 2\n"
+          "sum / even @4 1\n");
+
+    // Samples taken while a helper was running aren't at any offset
+    std::ostringstream report;
+    sampler.report(report);
+    auto dup = report.str().find("50.0%         1  dup");
+    auto sum = report.str().find("25.0%         4  sum / even");
+    REQUIRE(dup != std::string::npos);
+    REQUIRE(sum != std::string::npos);
+    CHECK(dup < sum);
+    CHECK(report.str().find("do_map") == std::string::npos);
+}
+
+TEST_CASE("Testing sampling a running program") {
+    auto engine = GENERATE(gs2::Engine::TreeWalker, gs2::Engine::Threaded);
+    auto threads = GENERATE(1, 4);
+
+    // Maps dup and add over a long range, and then sums it
+    std::vector<uint8_t> code{0x03, 0x40, 0x0d, 0x03, 0x00, 0x2f, 0x08, 0x40, 0x30, 0x09, 0x34, 0x64};
+    auto block = gs2::Block::parseBytes(code);
+
+    gs2::Sampler sampler{std::chrono::microseconds{100}};
+
+    gs2::List stack;
+    gs2::GS2Context gs2{stack};
+    gs2.setEngine(engine);
+    gs2.setThreads(threads);
+    gs2.setSampler(&sampler);
+
+    for (int runs = 0; runs < 2000 && sampler.getTotal() < 50; runs++) {
+        stack.clear();
+        block.execute(gs2);
+        REQUIRE(stack.size() == 1);
+    }
+
+    // Anything sampled inside the block is under the map which runs it
+    std::ostringstream folded;
+    sampler.writeFolded(folded);
+    std::istringstream lines{folded.str()};
+    std::string line;
+    bool inBlock = false;
+    while (std::getline(lines, line)) {
+        auto nested = line.find(';');
+        if (nested != std::string::npos) {
+            CHECK(line.substr(0, nested) == "mod / step / clean-split / map @10");
+        }
+        inBlock = inBlock || line.find(";do_map;") != std::string::npos;
+    }
+
+    // The map is long enough to be split between threads if it weren't being
+    // sampled, and then nothing inside its block would be seen
+    CHECK(inBlock);
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "catch2/catch.hpp"
 
 #include "gs2exception.hpp"
+#include "search.hpp"
 #include "utils.hpp"
 #include "value.hpp"
 
@@ -9,6 +10,11 @@ TEST_CASE("makeString tests") {
     auto result = gs2::makeString(0x42);
     CHECK(result == "\x42");
 
+    // Numbers which don't fit in a char saturate
+    CHECK(gs2::makeString(300) == "\x7f");
+    CHECK(gs2::makeString(-300) == "\x80");
+    CHECK(gs2::makeString(gs2::Value::IntType{"1180591620717411303424"}) == "\x7f");
+
     gs2::List list;
     list.add('H');
     list.add('e');
@@ -28,3 +34,106 @@ TEST_CASE("makeString tests") {
     // A block cannot be converted to a string
     CHECK_THROWS_AS(gs2::makeString(gs2::Block{}), gs2::GS2Exception);
 }
+
+TEST_CASE("findByte tests") {
+    // Check every position in strings long enough to use vector instructions,
+    // starting at different alignments
+    std::vector<uint8_t> bytes(100, 'a');
+
+    for (size_t start = 0; start < 4; start++) {
+        for (size_t i = start; i < bytes.size(); i++) {
+            bytes[i] = '\n';
+            auto found = gs2::findByte(bytes.data() + start, bytes.data() + bytes.size(), '\n');
+            CHECK(found == bytes.data() + i);
+            bytes[i] = 'a';
+        }
+
+        auto notFound = gs2::findByte(bytes.data() + start, bytes.data() + bytes.size(), '\n');
+        CHECK(notFound == bytes.data() + bytes.size());
+    }
+
+    CHECK(gs2::findByte(bytes.data(), bytes.data(), 'a') == bytes.data());
+}
+
+TEST_CASE("split tests") {
+    auto toStrings = [] (const gs2::List &list) {
+        std::vector<std::string> strings;
+        for (const auto &piece: list) {
+            strings.push_back(gs2::makeString(piece));
+        }
+        return strings;
+    };
+
+    auto text = gs2::makeList("one,two,,three,");
+    using Strings = std::vector<std::string>;
+
+    CHECK(toStrings(gs2::split(text, gs2::makeList(","))) == Strings{"one", "two", "", "three", ""});
+    CHECK(toStrings(gs2::split(text, gs2::makeList(","), true)) == Strings{"one", "two", "three"});
+    CHECK(toStrings(gs2::split(gs2::makeList(""), gs2::makeList(","))) == Strings{""});
+    CHECK(gs2::split(gs2::makeList(""), gs2::makeList(","), true).empty());
+
+    // Only splitting something on an empty separator is an error
+    CHECK(toStrings(gs2::split(gs2::List{}, gs2::List{})) == Strings{""});
+    CHECK(gs2::split(gs2::List{}, gs2::List{}, true).empty());
+    CHECK_THROWS_AS(gs2::split(text, gs2::List{}), gs2::GS2Exception);
+
+    // Separators which aren't stored as a byte string are split on the same way
+    gs2::List comma;
+    comma.add(gs2::Block{});
+    comma.pop();
+    comma.add(',');
+    CHECK_FALSE(comma.isBytes());
+    CHECK(toStrings(gs2::split(text, comma)) == Strings{"one", "two", "", "three", ""});
+
+    // The same splits on a list that isn't a byte string
+    gs2::List values;
+    values.add(gs2::Block{});
+    values.pop();
+    values.concat(text);
+    CHECK(toStrings(gs2::split(values, gs2::makeList(","))) == Strings{"one", "two", "", "three", ""});
+    CHECK(toStrings(gs2::split(values, gs2::makeList(","), true)) == Strings{"one", "two", "three"});
+
+    std::string longLine(1000, 'x');
+    auto longText = gs2::makeList(longLine + "\n" + longLine + "\n\n" + longLine);
+    CHECK(toStrings(gs2::split(longText, gs2::makeList("\n"))) == Strings{longLine, longLine, "", longLine});
+}
+
+TEST_CASE("split tests with longer separators") {
+    auto toStrings = [] (const gs2::List &list) {
+        std::vector<std::string> strings;
+        for (const auto &piece: list) {
+            strings.push_back(gs2::makeString(piece));
+        }
+        return strings;
+    };
+    using Strings = std::vector<std::string>;
+
+    auto text = gs2::makeList("a, b,, c, , d\r\n\r\ne, ");
+    CHECK(toStrings(gs2::split(text, gs2::makeList(", "))) == Strings{"a", "b,", "c", "", "d\r\n\r\ne", ""});
+    CHECK(toStrings(gs2::split(text, gs2::makeList(", "), true)) == Strings{"a", "b,", "c", "d\r\n\r\ne"});
+    CHECK(toStrings(gs2::split(text, gs2::makeList("\r\n"), true)) == Strings{"a, b,, c, , d", "e, "});
+
+    // Separators are matched from the left, without overlapping
+    CHECK(toStrings(gs2::split(gs2::makeList("aaaaa"), gs2::makeList("aa"))) == Strings{"", "", "a"});
+    CHECK(toStrings(gs2::split(gs2::makeList("abababc"), gs2::makeList("ababc"))) == Strings{"ab", ""});
+
+    // A separator which almost matches everywhere
+    std::string as(10000, 'a');
+    auto pathological = gs2::split(gs2::makeList(as + "b" + as), gs2::makeList(std::string(1000, 'a') + "b"));
+    CHECK(toStrings(pathological) == Strings{std::string(9000, 'a'), as});
+
+    // The same splits on lists that aren't byte strings
+    gs2::List values;
+    values.add(gs2::Block{});
+    values.pop();
+    values.concat(text);
+    gs2::List sep;
+    sep.add(gs2::Block{});
+    sep.pop();
+    sep.concat(gs2::makeList(", "));
+    CHECK(toStrings(gs2::split(values, sep)) == Strings{"a", "b,", "c", "", "d\r\n\r\ne", ""});
+    CHECK(toStrings(gs2::split(values, sep, true)) == Strings{"a", "b,", "c", "d\r\n\r\ne"});
+    CHECK(toStrings(gs2::split(text, sep, true)) == Strings{"a", "b,", "c", "d\r\n\r\ne"});
+
+    CHECK_THROWS_AS(gs2::split(text, gs2::List{}), gs2::GS2Exception);
+}